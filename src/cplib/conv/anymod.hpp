@@ -1,83 +1,287 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 #include "cplib/conv/conv.hpp"
+#include "cplib/port/bit.hpp"
 
 namespace cplib {
 
 namespace impl {
 
+// Squares a if a and b are the same object.
 template <typename In, typename Out>
-std::vector<Out> convolve_modint(const std::vector<In>& a, const std::vector<In>& b) {
+std::vector<Out> convolve_modint(const std::vector<In>& a, const std::vector<In>& b, unsigned num_threads) {
   std::vector<Out> a_modint, b_modint;
   a_modint.reserve(a.size());
   for (const In& x : a) {
     a_modint.emplace_back(x.val());
   }
+  if (&a == &b) {
+    square_inplace(a_modint, num_threads);
+    return a_modint;
+  }
   b_modint.reserve(b.size());
   for (const In& x : b) {
     b_modint.emplace_back(x.val());
   }
-  convolve_inplace2(a_modint, b_modint);
+  convolve_inplace2(a_modint, b_modint, num_threads);
   return a_modint;
 }
 
 template <typename In, typename Out, typename ModInt1, typename ModInt2>
-std::vector<Out> convolve_with_two_modints(const std::vector<In>& a, const std::vector<In>& b) {
-  std::vector<ModInt1> m1 = convolve_modint<In, ModInt1>(a, b);
-  std::vector<ModInt2> m2 = convolve_modint<In, ModInt2>(a, b);
-  std::vector<Out> ret;
-  ret.reserve(m1.size());
-  ModInt2 p1_inv = ModInt2(ModInt1::mod()).inv();
-  Out p1_out(ModInt1::mod());
-  for (std::size_t i = 0; i < m1.size(); i++) {
-    // r1+k*p1=r2 (mod p2) => k=(r2-r1)*p1^{-1} (mod p2)
-    auto r1 = m1[i].val();
-    auto k = ((m2[i] - ModInt2(r1)) * p1_inv).val();
-    ret.push_back(Out(r1) + Out(k) * p1_out);
+std::vector<Out> convolve_with_two_modints(const std::vector<In>& a, const std::vector<In>& b, unsigned num_threads) {
+  std::vector<ModInt1> m1;
+  std::vector<ModInt2> m2;
+  const std::size_t out_size = a.size() + b.size() - 1;
+  if (fft_worth_parallel<ModInt1>(out_size, num_threads)) {
+    unsigned threads2 = num_threads / 2;
+    parallel_invoke([&] { m1 = convolve_modint<In, ModInt1>(a, b, num_threads - threads2); },
+                    [&] { m2 = convolve_modint<In, ModInt2>(a, b, threads2); });
+  } else {
+    m1 = convolve_modint<In, ModInt1>(a, b, 1);
+    m2 = convolve_modint<In, ModInt2>(a, b, 1);
   }
+  std::vector<Out> ret(m1.size());
+  const ModInt2 p1_inv = ModInt2(ModInt1::mod()).inv();
+  const Out p1_out(ModInt1::mod());
+  const std::size_t chunk = std::min(m1.size(), fft_row_length<ModInt1>());
+  parallel_for(0, (m1.size() + chunk - 1) / chunk, num_threads, [&](std::size_t c) {
+    for (std::size_t i = c * chunk; i < std::min(m1.size(), (c + 1) * chunk); i++) {
+      // r1+k*p1=r2 (mod p2) => k=(r2-r1)*p1^{-1} (mod p2)
+      auto r1 = m1[i].val();
+      auto k = ((m2[i] - ModInt2(r1)) * p1_inv).val();
+      ret[i] = Out(r1) + Out(k) * p1_out;
+    }
+  });
   return ret;
 }
 
+template <typename In, typename Out, typename ModInt1, typename ModInt2, typename ModInt3>
+std::vector<Out> convolve_with_three_modints(const std::vector<In>& a, const std::vector<In>& b,
+                                             unsigned num_threads) {
+  std::vector<ModInt1> m1;
+  std::vector<ModInt2> m2;
+  std::vector<ModInt3> m3;
+  const std::size_t out_size = a.size() + b.size() - 1;
+  if (num_threads >= 3 && fft_worth_parallel<ModInt1>(out_size, num_threads)) {
+    const unsigned threads2 = num_threads / 3, threads3 = num_threads / 3, threads1 = num_threads - threads2 - threads3;
+    parallel_invoke([&] { m1 = convolve_modint<In, ModInt1>(a, b, threads1); },
+                    [&] {
+                      parallel_invoke([&] { m2 = convolve_modint<In, ModInt2>(a, b, threads2); },
+                                      [&] { m3 = convolve_modint<In, ModInt3>(a, b, threads3); });
+                    });
+  } else {
+    // Too few threads to give one to each prime, so each convolution uses all of them in turn.
+    m1 = convolve_modint<In, ModInt1>(a, b, num_threads);
+    m2 = convolve_modint<In, ModInt2>(a, b, num_threads);
+    m3 = convolve_modint<In, ModInt3>(a, b, num_threads);
+  }
+  std::vector<Out> ret(m1.size());
+  const ModInt2 p1_inv = ModInt2(ModInt1::mod()).inv();
+  const ModInt3 p1_mod3(ModInt1::mod()), p12_inv = (p1_mod3 * ModInt3(ModInt2::mod())).inv();
+  const Out p1_out(ModInt1::mod()), p12_out = p1_out * Out(ModInt2::mod());
+  const std::size_t chunk = std::min(m1.size(), fft_row_length<ModInt1>());
+  parallel_for(0, (m1.size() + chunk - 1) / chunk, num_threads, [&](std::size_t c) {
+    for (std::size_t i = c * chunk; i < std::min(m1.size(), (c + 1) * chunk); i++) {
+      // Garner's algorithm: the result is r1+k1*p1+k2*p1*p2, where each k is solved modulo the next prime.
+      auto r1 = m1[i].val();
+      auto k1 = ((m2[i] - ModInt2(r1)) * p1_inv).val();
+      auto k2 = ((m3[i] - ModInt3(r1) - ModInt3(k1) * p1_mod3) * p12_inv).val();
+      ret[i] = Out(r1) + Out(k1) * p1_out + Out(k2) * p12_out;
+    }
+  });
+  return ret;
+}
+
+// Convolution with std::complex<double> FFT, where each value is split into two halves of `shift` bits, packed as
+// the real and imaginary parts of one complex number. The products of halves are separated from the transforms by
+// conjugate symmetry, and packed into two inverse transforms, for four transforms in total. Squares a if a and b are
+// the same object.
+template <typename ModInt>
+std::vector<ModInt> convolve_with_split_complex(const std::vector<ModInt>& a, const std::vector<ModInt>& b, int shift,
+                                                unsigned num_threads) {
+  using usize = std::size_t;
+  using cd = std::complex<double>;
+  const usize out_size = a.size() + b.size() - 1, len = port::bit_ceil(out_size);
+  const int64_t mod = ModInt::mod(), half = int64_t(1) << (shift - 1);
+  auto split = [&](const std::vector<ModInt>& x) {
+    std::vector<cd> ret(len);
+    for (usize i = 0; i < x.size(); i++) {
+      // Balanced representation v=hi*2^shift+lo with |v|<=mod/2 and -2^(shift-1)<=lo<2^(shift-1), which makes the
+      // values about half as large and the rounding error of random inputs grow much slower.
+      int64_t v = x[i].val();
+      v = v * 2 > mod ? v - mod : v;
+      int64_t lo = ((v + half) & (half * 2 - 1)) - half;
+      ret[i] = cd(double(lo), double((v - lo) >> shift));
+    }
+    fft_inplace(ret, num_threads);
+    return ret;
+  };
+  std::vector<cd> fa = split(a), fb = &a == &b ? fa : split(b);
+  const usize chunk = std::min(len, fft_row_length<cd>());
+  parallel_for(0, len / chunk, num_threads, [&](usize c) {
+    for (usize p = c * chunk; p < (c + 1) * chunk; p++) {
+      // In bit-reversed order, frequencies k and -k are at p and p^(bit_floor(p)-1).
+      const usize q = p == 0 ? 0 : p ^ (port::bit_floor(p) - 1);
+      if (q < p) {
+        continue;
+      }
+      // Transforms of the low and high halves of a and b at both frequencies.
+      const cd a_lo_p = (fa[p] + std::conj(fa[q])) * 0.5, a_hi_p = (fa[p] - std::conj(fa[q])) * cd(0, -0.5);
+      const cd b_lo_p = (fb[p] + std::conj(fb[q])) * 0.5, b_hi_p = (fb[p] - std::conj(fb[q])) * cd(0, -0.5);
+      const cd a_lo_q = std::conj(a_lo_p), a_hi_q = std::conj(a_hi_p);
+      const cd b_lo_q = std::conj(b_lo_p), b_hi_q = std::conj(b_hi_p);
+      fa[p] = a_lo_p * b_lo_p + a_hi_p * b_hi_p * cd(0, 1);
+      fb[p] = a_lo_p * b_hi_p + a_hi_p * b_lo_p;
+      fa[q] = a_lo_q * b_lo_q + a_hi_q * b_hi_q * cd(0, 1);
+      fb[q] = a_lo_q * b_hi_q + a_hi_q * b_lo_q;
+    }
+  });
+  ifft_inplace(fa, num_threads);
+  ifft_inplace(fb, num_threads);
+  std::vector<ModInt> ret(out_size);
+  const ModInt mul_mid(uint64_t(1) << shift), mul_hi = mul_mid * mul_mid;
+  auto to_modint = [&](double x) {
+    int64_t r = std::llround(x);
+    return ModInt(r >= 0 ? uint64_t(r) : uint64_t(mod) - uint64_t(-r) % uint64_t(mod));
+  };
+  parallel_for(0, (out_size + chunk - 1) / chunk, num_threads, [&](usize c) {
+    for (usize i = c * chunk; i < std::min(out_size, (c + 1) * chunk); i++) {
+      ret[i] = to_modint(fa[i].real()) + to_modint(fb[i].real()) * mul_mid + to_modint(fa[i].imag()) * mul_hi;
+    }
+  });
+  return ret;
+}
+
+// Returns the number of bits in the lower half for convolve_with_split_complex(), or 0 if the rounding error may be
+// too large. With balanced halves |lo|,|hi|<=B=2^(shift-1), the error of each output is about
+// B^2*min_size*log2(len)*eps in the worst case, so B^2*min_size*log2(len)<=2^47 keeps it well below 1/2, while random
+// inputs have far smaller errors.
+inline int split_complex_shift(uint64_t mod, std::size_t min_size, std::size_t len) {
+  const int shift = std::max((port::bit_width(mod - 1) + 1) / 2, 1);
+  if (shift > 24) {
+    return 0;
+  }
+  using u128 = unsigned __int128;
+  const u128 bound = (u128(1) << (shift * 2 - 2)) * min_size * std::max(port::countr_zero(len), 1);
+  return bound <= (u128(1) << 47) ? shift : 0;
+}
+
+// Three 32-bit primes are faster than two 64-bit primes only if the 32-bit transforms are vectorized.
+constexpr bool anymod_three_primes = !std::is_same_v<typename fft_kernel<MMInt<167772161>>::type,
+                                                     typename fft_generic_kernel<MMInt<167772161>>::type>;
+
+// Since FFT convolution is done modulo several primes, Karatsuba's algorithm wins up to larger lengths, even more so
+// with deferred reduction for loose MontgomeryModInt.
+template <typename ModInt>
+constexpr ConvThresholds anymod_conv_thresholds() {
+  if constexpr (is_loose_mmint_v<ModInt>) {
+    return {192, anymod_three_primes ? 512 : 1024};
+  } else {
+    return {32, anymod_three_primes ? 128 : 192};
+  }
+}
+
+template <typename ModInt>
+std::vector<ModInt> convolve_any_modint_fft(const std::vector<ModInt>& a, const std::vector<ModInt>& b,
+                                            unsigned num_threads) {
+  using u128 = unsigned __int128;
+  const u128 max_prod = u128(ModInt::mod() - 1) * (ModInt::mod() - 1);
+  const std::size_t min_size = std::min(a.size(), b.size());
+  if constexpr (!anymod_three_primes) {
+    // Without vectorized 32-bit transforms, double FFT is about as fast as two 64-bit primes.
+    if (int shift = split_complex_shift(ModInt::mod(), min_size, port::bit_ceil(a.size() + b.size() - 1))) {
+      return convolve_with_split_complex(a, b, shift, num_threads);
+    }
+  }
+  if constexpr (anymod_three_primes) {
+    using mint1 = MMInt<167772161>;
+    using mint2 = MMInt<469762049>;
+    using mint3 = MMInt<754974721>;
+    const u128 limit = u128(mint1::mod()) * mint2::mod() * mint3::mod() - 1;
+    if (a.size() + b.size() - 1 <= (std::size_t(1) << radix2_fft_root<mint3>::max_log) &&
+        max_prod <= limit / min_size) {
+      return convolve_with_three_modints<ModInt, ModInt, mint1, mint2, mint3>(a, b, num_threads);
+    }
+  }
+  using mint1 = MMInt64<4512606826625236993>;
+  using mint2 = MMInt64<4242390848983007233>;
+  const u128 limit = u128(mint1::mod()) * mint2::mod() - 1;
+  assert(max_prod <= limit / min_size);
+  return convolve_with_two_modints<ModInt, ModInt, mint1, mint2>(a, b, num_threads);
+}
+
 }  // namespace impl
 
-template <>
-struct radix2_fft_root<MMInt64<4242390848983007233>> {
-  using mint = MMInt64<4242390848983007233>;
-  static mint get(int n) { return pow(mint(11), 471ull << (53 - n)); }
-};
+/**
+ * \brief In-place square with arbitrary modulus, i.e. convolution of an array with itself.
+ * \ingroup conv
+ *
+ * It takes one forward transform per modulus instead of two like convolve_any_modint_inplace() does, which saves a
+ * third of the work.
+ *
+ * \see convolve_any_modint_inplace() for other details.
+ */
+template <typename ModInt>
+void square_any_modint_inplace(std::vector<ModInt>& a, unsigned num_threads = 1) {
+  if (a.size() <= impl::anymod_conv_thresholds<ModInt>().naive) {
+    impl::square_naive_inplace(a);
+  } else if (a.size() <= impl::anymod_conv_thresholds<ModInt>().karatsuba) {
+    impl::conv_karatsuba_inplace(a, a);
+  } else {
+    a = impl::convolve_any_modint_fft(a, a, num_threads);
+  }
+}
 
 /**
  * \brief In-place convolution with arbitrary modulus.
  * \ingroup conv
  *
- * Using two 64-bit FFT-friendly prime moduli, it effectively computes convolution modulo a large number,
- * \f$M\approx 1.9\times 10^{37}\f$. When convolution modulo \f$P\f$ is interpreted as convolution over \f$\mathbb{N}\f$
- * followed by modulo, the intermediate value is at most \f$(P-1)^2\min\{N_1,N_2\}\f$, where \f$N_1,N_2\f$ are the
- * lengths of the two sequences. As long as this value is smaller than \f$M\f$, computation modulo \f$M\f$ gives
- * the unique and correct result.
+ * Using several FFT-friendly prime moduli, it effectively computes convolution modulo their product \f$M\f$, and
+ * reconstructs the result with the Chinese remainder theorem. When convolution modulo \f$P\f$ is interpreted as
+ * convolution over \f$\mathbb{N}\f$ followed by modulo, the intermediate value is at most
+ * \f$(P-1)^2\min\{N_1,N_2\}\f$, where \f$N_1,N_2\f$ are the lengths of the two sequences. As long as this value is
+ * smaller than \f$M\f$, computation modulo \f$M\f$ gives the unique and correct result.
  *
  * Typically in competitive programming, \f$P\approx 10^9\f$ and \f$N_1,N_2\lesssim 10^6\f$, so \f$M\f$ only
- * needs to be larger than \f$10^{25}\f$ or so. Arbitrary modulus convolution is more commonly implemented as three
- * 32-bit moduli, as they combined provide a sufficiently large \f$M\f$. However, benchmark shows that two 64-bit
- * moduli is about as fast as three 32-bit moduli on 64-bit platforms.
+ * needs to be larger than \f$10^{25}\f$ or so. This is satisfied by three 32-bit primes \f$167772161\f$,
+ * \f$469762049\f$ and \f$754974721\f$ with \f$M\approx 5.9\times 10^{25}\f$, which are used if the bound holds, the
+ * result length is at most \f$2^{24}\f$, and the 32-bit transforms are vectorized, in which case they are up to twice
+ * as fast. Otherwise two 64-bit primes are used, with \f$M\approx 1.9\times 10^{37}\f$.
+ *
+ * Without vectorized 32-bit transforms, small enough inputs are instead convolved with `std::complex<double>` FFT,
+ * where each value is split into two halves of \f$s=\lceil\log_2 P/2\rceil\f$ bits, taking four transforms in total.
+ * It is used only if \f$2^{2s-2}\min\{N_1,N_2\}\log_2 L\le 2^{47}\f$, where \f$L\f$ is the FFT length, which
+ * keeps the rounding error well below \f$1/2\f$ even for the worst inputs. For \f$P\approx 10^9\f$, this means
+ * \f$\min\{N_1,N_2\}\le 2^{15}\f$ or so, and larger inputs fall back to the prime moduli.
+ *
+ * With `num_threads` greater than 1, convolutions modulo each prime run concurrently on large inputs, and each is
+ * further parallelized as in convolve_inplace2(). With three primes and only two threads, they run one after another
+ * with both threads each.
+ *
+ * Short arrays are multiplied naively or with Karatsuba's algorithm, and FFT is used otherwise, similar to
+ * convolve_inplace2() but with different thresholds.
+ *
+ * If `a` and `b` are the same object, this is square_any_modint_inplace().
  *
- * \tparam ModInt A modint type. The only requirements are `operator+`, `opeartor*`, and conversion from `uint64_t`.
+ * \tparam ModInt A modint type. The requirements are `operator+`, `operator-`, `operator*`, `val()`, static `mod()`,
+ * and conversion from `uint64_t`. For loose MontgomeryModInt, naive multiplication with deferred reduction also uses
+ * `from_raw()` and `residue()`.
  */
 template <typename ModInt>
-void convolve_any_modint_inplace(std::vector<ModInt>& a, const std::vector<ModInt>& b) {
-  if (impl::conv_naive_is_efficient(a.size(), b.size())) {
-    impl::conv_naive_inplace(a, b);
-    return;
+void convolve_any_modint_inplace(std::vector<ModInt>& a, const std::vector<ModInt>& b, unsigned num_threads = 1) {
+  if (&a == &b) {
+    square_any_modint_inplace(a, num_threads);
+  } else if (!impl::conv_small_inplace(a, b, impl::anymod_conv_thresholds<ModInt>())) {
+    a = impl::convolve_any_modint_fft(a, b, num_threads);
   }
-  using mint1 = MMInt64<4512606826625236993>;
-  using mint2 = MMInt64<4242390848983007233>;
-  using u128 = unsigned __int128;
-  u128 max_prod = u128(ModInt::mod() - 1) * (ModInt::mod() - 1);
-  u128 limit = u128(mint1::mod()) * mint2::mod() - 1;
-  assert(max_prod <= limit / std::min(a.size(), b.size()));
-  a = impl::convolve_with_two_modints<ModInt, ModInt, mint1, mint2>(a, b);
 }
 
 /**
@@ -86,9 +290,26 @@ void convolve_any_modint_inplace(std::vector<ModInt>& a, const std::vector<ModIn
  * \see convolve_any_modint_inplace() for details.
  */
 template <typename ModInt>
-std::vector<ModInt> convolve_any_modint(const std::vector<ModInt>& a, const std::vector<ModInt>& b) {
+std::vector<ModInt> convolve_any_modint(const std::vector<ModInt>& a, const std::vector<ModInt>& b,
+                                        unsigned num_threads = 1) {
+  std::vector<ModInt> a_copy = a;
+  if (&a == &b) {
+    square_any_modint_inplace(a_copy, num_threads);
+  } else {
+    convolve_any_modint_inplace(a_copy, b, num_threads);
+  }
+  return a_copy;
+}
+
+/**
+ * \brief Returns the square of an array modulo an arbitrary integer.
+ * \ingroup conv
+ * \see square_any_modint_inplace() for details.
+ */
+template <typename ModInt>
+std::vector<ModInt> square_any_modint(const std::vector<ModInt>& a, unsigned num_threads = 1) {
   std::vector<ModInt> a_copy = a;
-  convolve_any_modint_inplace(a_copy, b);
+  square_any_modint_inplace(a_copy, num_threads);
   return a_copy;
 }
 
@@ -1,15 +1,178 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 #include "cplib/conv/fft.hpp"
 #include "cplib/port/bit.hpp"
+#include "cplib/utils/type.hpp"
+
+#pragma GCC push_options
+#ifndef _CPLIB_NO_FORCE_AVX2_
+#pragma GCC target("avx2")
+#endif
 
 namespace cplib {
 
 namespace impl {
 
-inline bool conv_naive_is_efficient(std::size_t n, std::size_t m) { return std::min(n, m) <= 32; }
+template <typename T>
+struct is_complex : std::false_type {};
+
+template <typename Float>
+struct is_complex<std::complex<Float>> : std::true_type {};
+
+template <typename T>
+constexpr bool is_complex_v = is_complex<T>::value;
+
+// Crossovers between convolution algorithms in terms of the length of the shorter array, as measured by the
+// benchmarks in test/conv/conv_benchmark.cpp. Naive multiplication is the fastest up to `naive`, then Karatsuba's
+// algorithm up to `karatsuba`, then FFT.
+struct ConvThresholds {
+  std::size_t naive, karatsuba;
+};
+
+// FFT is done in blocks of the longer array if it is at least this many times as long as the shorter one.
+constexpr std::size_t conv_split_ratio = 6;
+
+template <typename T>
+constexpr ConvThresholds conv_thresholds() {
+  if constexpr (is_loose_mmint_v<T>) {
+    // Naive multiplication with deferred reduction (conv_naive_lazy) beats Karatsuba's algorithm until FFT wins.
+    return {56, 56};
+  } else if constexpr (is_complex_v<T>) {
+    return {24, 24};
+  } else {
+    // Karatsuba's algorithm only wins right after FFT length doubles.
+    return {32, 48};
+  }
+}
+
+template <typename T>
+constexpr bool conv_naive_is_efficient(std::size_t n, std::size_t m) {
+  return std::min(n, m) <= conv_thresholds<T>().naive;
+}
+
+// Below this length Karatsuba's algorithm falls back to naive multiplication, which is much faster with deferred
+// reduction for loose MontgomeryModInt.
+template <typename T>
+constexpr std::size_t conv_karatsuba_base = is_loose_mmint_v<T> ? 128 : 32;
+
+// Sums of products of loose MontgomeryModInt values with deferred reduction.
+//
+// Raw values are shrunk into [0,N), and their products are summed in double-width integers without reduction, which
+// are R times the sum in Montgomery form. After every `chunk` terms the top two bits are folded back as 2^s mod N,
+// keeping the sum below 2^s+3N where s=2w-2 and w is the width of raw values, so that another `chunk` terms can be
+// added without overflow. Each sum is reduced only once at the end.
+template <typename T>
+struct LazyDotProduct {
+  using int_type = typename T::int_type;
+  using acc_type = make_double_width_t<int_type>;
+  static constexpr int width = std::numeric_limits<int_type>::digits;
+  static constexpr int fold_shift = width * 2 - 2;
+  static constexpr acc_type fold_mask = (acc_type(1) << fold_shift) - 1;
+
+  acc_type fold_mul;
+  std::size_t chunk;
+
+  LazyDotProduct() {
+    const acc_type mod = T::mod(), sq = (mod - 1) * (mod - 1);
+    fold_mul = (acc_type(1) << fold_shift) % mod;
+    const acc_type limit = ~acc_type(0) - (acc_type(1) << fold_shift) - mod * 3;
+    chunk = std::size_t(std::min(sq == 0 ? limit : limit / sq, acc_type(1) << 30));
+  }
+
+  acc_type fold(acc_type x) const { return (x & fold_mask) + (x >> fold_shift) * fold_mul; }
+
+  // Sum with the high half being x/R, and the low half reduced by a Montgomery multiplication by 1.
+  T reduce(acc_type x) const {
+    x = fold(x);
+    return T::from_raw(int_type(x >> width)) * T(1) + T::from_raw(int_type(x)) * T::from_raw(1);
+  }
+};
+
+// out[0,n+m-1) = a[0,n) * b[0,m) for non-empty loose MontgomeryModInt arrays, by LazyDotProduct. out may alias a or
+// b. With AVX2, 16 consecutive outputs are computed at a time with 32x32->64 multiplications.
+template <typename T>
+void conv_naive_lazy(const T* a, std::size_t n, const T* b, std::size_t m, T* out) {
+  using usize = std::size_t;
+  using int_type = typename T::int_type;
+  using acc_type = typename LazyDotProduct<T>::acc_type;
+  if (n < m) {
+    std::swap(a, b);
+    std::swap(n, m);
+  }
+  const LazyDotProduct<T> dot;
+  const usize out_size = n + m - 1;
+  std::vector<int_type> y(m);
+  for (usize j = 0; j < m; j++) {
+    y[j] = b[j].residue();
+  }
+#if defined(__AVX2__) || !defined(_CPLIB_NO_FORCE_AVX2_)
+  if constexpr (sizeof(int_type) == 4) {
+    constexpr usize lanes = 16;
+    const usize padded = (out_size + lanes - 1) / lanes * lanes;
+    // x[i+m-1]=a[i], padded with zeros on both sides so that out[t]=sum(x[t+m-1-j]*y[j]) for all j<m.
+    std::vector<uint32_t> x(padded + m - 1, 0);
+    for (usize i = 0; i < n; i++) {
+      x[i + m - 1] = a[i].residue();
+    }
+    const __m256i fold_mask = _mm256_set1_epi64x(dot.fold_mask), fold_mul = _mm256_set1_epi64x(dot.fold_mul);
+    auto fold = [&](__m256i v) {
+      return _mm256_add_epi64(_mm256_and_si256(v, fold_mask),
+                              _mm256_mul_epu32(_mm256_srli_epi64(v, dot.fold_shift), fold_mul));
+    };
+    alignas(32) uint64_t sums[lanes];
+    for (usize t = 0; t < padded; t += lanes) {
+      __m256i acc[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(),
+                        _mm256_setzero_si256()};
+      const usize j_low = t < n ? 0 : t - n + 1, j_high = std::min(m - 1, t + lanes - 1);
+      for (usize j = j_low; j <= j_high;) {
+        const usize j_end = std::min(j_high + 1, j + dot.chunk);
+        for (; j < j_end; j++) {
+          const __m256i yj = _mm256_set1_epi64x(y[j]);
+          const uint32_t* p = x.data() + t + m - 1 - j;
+          for (int k = 0; k < 4; k++) {
+            __m256i xk = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k * 4)));
+            acc[k] = _mm256_add_epi64(acc[k], _mm256_mul_epu32(xk, yj));
+          }
+        }
+        for (int k = 0; k < 4; k++) {
+          acc[k] = fold(acc[k]);
+        }
+      }
+      for (int k = 0; k < 4; k++) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(sums + k * 4), acc[k]);
+      }
+      for (usize l = 0; l < lanes && t + l < out_size; l++) {
+        out[t + l] = dot.reduce(sums[l]);
+      }
+    }
+    return;
+  }
+#endif
+  std::vector<int_type> x(n);
+  for (usize i = 0; i < n; i++) {
+    x[i] = a[i].residue();
+  }
+  for (usize t = 0; t < out_size; t++) {
+    const usize j_low = t < n ? 0 : t - n + 1, j_high = std::min(m - 1, t);
+    acc_type sum = 0;
+    for (usize j = j_low; j <= j_high;) {
+      const usize j_end = std::min(j_high + 1, j + dot.chunk);
+      for (; j < j_end; j++) {
+        sum += acc_type(x[t - j]) * y[j];
+      }
+      sum = dot.fold(sum);
+    }
+    out[t] = dot.reduce(sum);
+  }
+}
 
 template <typename T>
 void conv_naive_inplace(std::vector<T>& a, const std::vector<T>& b) {
@@ -17,6 +180,12 @@ void conv_naive_inplace(std::vector<T>& a, const std::vector<T>& b) {
     a.clear();
     return;
   }
+  if constexpr (is_loose_mmint_v<T>) {
+    const std::size_t n = a.size();
+    a.resize(n + b.size() - 1);
+    conv_naive_lazy(a.data(), n, b.data(), b.size(), a.data());
+    return;
+  }
   using usize = std::size_t;
   usize a_deg = a.size() - 1, b_deg = b.size() - 1;
   a.resize(a_deg + b_deg + 1, T(0));
@@ -33,22 +202,455 @@ void conv_naive_inplace(std::vector<T>& a, const std::vector<T>& b) {
   a[0] *= b[0];
 }
 
+// out[0,2n-1) = a[0,n) * b[0,n) by Karatsuba's algorithm, where scratch has room for at least 5n elements.
+template <typename T>
+void conv_karatsuba(const T* a, const T* b, std::size_t n, T* out, T* scratch) {
+  using usize = std::size_t;
+  if (n <= conv_karatsuba_base<T>) {
+    if constexpr (is_loose_mmint_v<T>) {
+      conv_naive_lazy(a, n, b, n, out);
+      return;
+    }
+    std::fill(out, out + n * 2 - 1, T(0));
+    for (usize i = 0; i < n; i++) {
+      for (usize j = 0; j < n; j++) {
+        out[i + j] += a[i] * b[j];
+      }
+    }
+    return;
+  }
+  // a=a0+a1*x^h and b=b0+b1*x^h, with a1 and b1 being no shorter than a0 and b0.
+  const usize h = n / 2, k = n - h;
+  T *a_sum = scratch, *b_sum = scratch + k, *mid = scratch + k * 2;
+  for (usize i = 0; i < k; i++) {
+    a_sum[i] = a[h + i];
+    b_sum[i] = b[h + i];
+  }
+  for (usize i = 0; i < h; i++) {
+    a_sum[i] += a[i];
+    b_sum[i] += b[i];
+  }
+  conv_karatsuba(a_sum, b_sum, k, mid, scratch + k * 4);
+  conv_karatsuba(a, b, h, out, scratch + k * 4);
+  conv_karatsuba(a + h, b + h, k, out + h * 2, scratch + k * 4);
+  out[h * 2 - 1] = T(0);
+  for (usize i = 0; i < h * 2 - 1; i++) {
+    mid[i] -= out[i];
+  }
+  for (usize i = 0; i < k * 2 - 1; i++) {
+    mid[i] -= out[h * 2 + i];
+  }
+  for (usize i = 0; i < k * 2 - 1; i++) {
+    out[h + i] += mid[i];
+  }
+}
+
+// Convolution of a long array `a` with a short array of length `b_size`, by splitting `a` into blocks of `block`
+// elements, and adding up the results of f(x) which replaces each block x with its convolution with the short array.
+template <typename T, typename Func>
+std::vector<T> conv_overlap_add(const std::vector<T>& a, std::size_t b_size, std::size_t block, Func&& f) {
+  using usize = std::size_t;
+  std::vector<T> out(a.size() + b_size - 1, T(0)), buf;
+  for (usize start = 0; start < a.size(); start += block) {
+    buf.assign(a.begin() + start, a.begin() + std::min(a.size(), start + block));
+    f(buf);
+    for (usize i = 0; i < buf.size(); i++) {
+      out[start + i] += buf[i];
+    }
+  }
+  return out;
+}
+
+// Convolution of non-empty arrays, where the longer one is split into blocks of the length of the shorter one, each
+// multiplied with Karatsuba's algorithm.
+template <typename T>
+void conv_karatsuba_inplace(std::vector<T>& a, const std::vector<T>& b) {
+  using usize = std::size_t;
+  const bool a_short = a.size() < b.size();
+  const std::vector<T>& short_vec = a_short ? a : b;
+  const usize n = short_vec.size();
+  std::vector<T> scratch(n * 7);
+  T* out = scratch.data() + n * 5;
+  a = conv_overlap_add(a_short ? b : a, n, n, [&](std::vector<T>& x) {
+    usize len = x.size();
+    x.resize(n, T(0));
+    conv_karatsuba(x.data(), short_vec.data(), n, out, scratch.data());
+    x.assign(out, out + len + n - 1);
+  });
+}
+
+// Pointwise product of transformed a and b of the same length, transformed back into a.
+template <typename T>
+void conv_transformed_inplace(std::vector<T>& a, const std::vector<T>& b, unsigned num_threads) {
+  using usize = std::size_t;
+  const usize n = a.size();
+  const usize chunk = std::min(n, fft_row_length<T>());
+  parallel_for(0, n / chunk, num_threads, [&](usize k) {
+    for (usize i = k * chunk; i < (k + 1) * chunk; i++) {
+      a[i] *= b[i];
+    }
+  });
+  ifft_inplace(a, num_threads);
+}
+
+// Convolution of non-empty arrays, where the longer one is split into blocks, each convolved with the shorter one
+// whose transform is computed only once. The transform length is 4 times the shorter length (rounded up to a power of
+// two), so each block is 3 times as long, which minimizes the number of butterflies per element of the longer array.
+template <typename T>
+void conv_fft_blocked_inplace(std::vector<T>& a, const std::vector<T>& b, unsigned num_threads) {
+  using usize = std::size_t;
+  const bool a_short = a.size() < b.size();
+  const usize n = std::min(a.size(), b.size()), len = port::bit_ceil(n * 4);
+  std::vector<T> transformed = a_short ? a : b;
+  transformed.resize(len, T(0));
+  fft_inplace(transformed, num_threads);
+  a = conv_overlap_add(a_short ? b : a, n, len - n + 1, [&](std::vector<T>& x) {
+    usize out_size = x.size() + n - 1;
+    x.resize(len, T(0));
+    fft_inplace(x, num_threads);
+    conv_transformed_inplace(x, transformed, num_threads);
+    x.resize(out_size);
+  });
+}
+
+// Whether T has 2^k-th root of unity, which complex numbers have for any k.
+template <typename T>
+constexpr bool fft_has_root(int k) {
+  if constexpr (is_complex_v<T>) {
+    return true;
+  } else {
+    return k <= radix2_fft_root<T>::max_log;
+  }
+}
+
+// Primitive r*2^k-th roots of unity for odd radices r, used by mixed-radix convolution. They exist for prime moduli
+// known at compile time when r divides `odd_part`, the odd part of p-1, and 2^k is at most that of p-1.
+template <typename T>
+struct odd_radix_fft_root {
+  static constexpr uint64_t odd_part = 1;
+};
+
+template <typename UInt, UInt Mod>
+struct odd_radix_fft_root<MontgomeryModInt<StaticMontgomeryReductionContext<UInt, Mod>>> {
+  using mint = MontgomeryModInt<StaticMontgomeryReductionContext<UInt, Mod>>;
+  static constexpr uint64_t odd_part = (Mod - 1) >> port::countr_zero(UInt(Mod - 1));
+
+  static mint get(unsigned r, int k) {
+    assert(odd_part % r == 0 && k <= radix2_fft_root<mint>::max_log);
+    return pow(mint(primitive_root_prime_constexpr(Mod)), uint64_t((Mod - 1) / r) >> k);
+  }
+};
+
+// Odd radices of mixed-radix convolution are at most this.
+constexpr std::size_t conv_max_radix = 7;
+
+// Relative cost per element of mixed-radix convolution with radix r, compared to that of power-of-two length, as
+// measured by the benchmarks in test/conv/conv_benchmark.cpp. The radix-r passes take about r multiplications per
+// element, so a larger radix must save more length to pay off.
+constexpr double conv_radix_cost(std::size_t r) { return r == 1 ? 1 : 1 + 0.05 * double(r); }
+
+// Transform length r*len for a linear convolution of out_size terms, with len a power of two, r=1 or an odd radix
+// supported by odd_radix_fft_root<T>.
+struct ConvFftLength {
+  std::size_t radix, len;
+};
+
+template <typename T>
+ConvFftLength conv_fft_length(std::size_t out_size) {
+  ConvFftLength ret{1, port::bit_ceil(out_size)};
+  if constexpr (odd_radix_fft_root<T>::odd_part > 1) {
+    // A power-of-two length without root of unity is never chosen if any odd radix works.
+    double best = fft_has_root<T>(port::countr_zero(ret.len)) ? double(ret.len) : HUGE_VAL;
+    for (std::size_t r = 3; r <= conv_max_radix; r += 2) {
+      const std::size_t len = port::bit_ceil((out_size + r - 1) / r);
+      const double cost = double(r * len) * conv_radix_cost(r);
+      if (odd_radix_fft_root<T>::odd_part % r == 0 && len >= 64 &&
+          port::countr_zero(len) <= radix2_fft_root<T>::max_log && cost < best) {
+        ret = {r, len};
+        best = cost;
+      }
+    }
+  }
+  return ret;
+}
+
+// A single element with the interface of MMIntx8, for radix-r passes over types without vectorized FFT.
+template <typename T>
+struct ConvScalarLane {
+  T v;
+
+  ConvScalarLane() = default;
+
+  explicit ConvScalarLane(const T& x) : v(x) {}
+
+  static ConvScalarLane load(const T* p) { return ConvScalarLane(*p); }
+
+  void store(T* p) const { *p = v; }
+
+  ConvScalarLane operator+(const ConvScalarLane& rhs) const { return ConvScalarLane(v + rhs.v); }
+
+  ConvScalarLane operator-(const ConvScalarLane& rhs) const { return ConvScalarLane(v - rhs.v); }
+
+  ConvScalarLane operator*(const ConvScalarLane& rhs) const { return ConvScalarLane(v * rhs.v); }
+
+  ConvScalarLane& operator+=(const ConvScalarLane& rhs) { return *this = *this + rhs; }
+
+  ConvScalarLane& operator*=(const ConvScalarLane& rhs) { return *this = *this * rhs; }
+};
+
+// Elements processed at once by radix-r passes, which are vectorized along with FFT.
+template <typename T, typename = void>
+struct conv_radix_lane {
+  using type = ConvScalarLane<T>;
+};
+
+#if defined(__AVX2__) || !defined(_CPLIB_NO_FORCE_AVX2_)
+template <uint32_t Mod>
+struct conv_radix_lane<MMInt<Mod>, std::enable_if_t<std::is_same_v<typename fft_kernel<MMInt<Mod>>::type,
+                                                                   FftAvx2Kernel<Mod>>>> {
+  using type = MMIntx8<Mod>;
+};
+#endif
+
+// Radix-r pass of mixed-radix convolution over r blocks of length len. a(x) mod x^len-w^i, with w=z^len a primitive
+// r-th root of unity, is the sum of blocks weighted by w^{it}, i.e. a DFT of length r over blocks, and substituting
+// x=z^i y makes it a polynomial modulo y^len-1, whose coefficients are twisted by z^{ij}. Block i is replaced by it.
+//
+// The inverse pass twists by z^{-ij}/r first, then does the DFT with w^{-1}, which recovers the blocks of the cyclic
+// convolution from those modulo each y^len-1.
+template <typename T>
+void conv_radix_pass(std::vector<T>& a, std::size_t r, std::size_t len, const T& z, bool inverse,
+                     unsigned num_threads) {
+  using usize = std::size_t;
+  using V = typename conv_radix_lane<T>::type;
+  constexpr usize width = sizeof(V) / sizeof(T);
+  const T z_dir = inverse ? T(1) / z : z, w = pow(z_dir, len), scale = inverse ? T(1) / T(r) : T(1);
+  assert(r <= conv_max_radix);
+  V w_pow[conv_max_radix];
+  for (usize m = 0; m < r; m++) {
+    w_pow[m] = V(pow(w, m));
+  }
+  const usize chunk = std::min(len, fft_row_length<T>());
+  parallel_for(0, len / chunk, num_threads, [&](usize c) {
+    // twist[i] holds z^{i(j+k)} in lane k for the current j, times the scale.
+    V twist[conv_max_radix], step[conv_max_radix], x[conv_max_radix];
+    for (usize i = 0; i < r; i++) {
+      const T zi = pow(z_dir, i);
+      T lanes[width];
+      lanes[0] = pow(zi, c * chunk) * scale;
+      for (usize k = 1; k < width; k++) {
+        lanes[k] = lanes[k - 1] * zi;
+      }
+      twist[i] = V::load(lanes);
+      step[i] = V(pow(zi, width));
+    }
+    for (usize j = c * chunk; j < (c + 1) * chunk; j += width) {
+      for (usize t = 0; t < r; t++) {
+        x[t] = V::load(&a[t * len + j]);
+        if (inverse) {
+          x[t] = x[t] * twist[t];
+          twist[t] *= step[t];
+        }
+      }
+      for (usize i = 0; i < r; i++) {
+        V y = x[0];
+        if (r == 3) {
+          // With w^2=-1-w, the DFT of length 3 takes one multiplication.
+          const V m = (x[1] - x[2]) * w_pow[1];
+          y = i == 0 ? x[0] + x[1] + x[2] : i == 1 ? x[0] - x[2] + m : x[0] - x[1] - m;
+        } else {
+          for (usize t = 1; t < r; t++) {
+            y += i == 0 ? x[t] : x[t] * w_pow[i * t % r];
+          }
+        }
+        if (!inverse) {
+          y *= twist[i];
+          twist[i] *= step[i];
+        }
+        y.store(&a[i * len + j]);
+      }
+    }
+  });
+}
+
+// Cyclic convolution of length r*len for odd r, done as r cyclic convolutions of length len between the radix-r
+// passes. Squares a if a and b are the same object.
+template <typename T>
+void conv_mixed_radix_inplace2(std::vector<T>& a, std::vector<T>& b, std::size_t r, std::size_t len,
+                               unsigned num_threads) {
+  const T z = odd_radix_fft_root<T>::get(unsigned(r), port::countr_zero(len));
+  const bool square = &a == &b;
+  a.resize(r * len, T(0));
+  b.resize(r * len, T(0));
+  conv_radix_pass(a, r, len, z, false, num_threads);
+  if (!square) {
+    conv_radix_pass(b, r, len, z, false, num_threads);
+  }
+  for (std::size_t i = 0; i < r; i++) {
+    const auto a_first = a.begin() + i * len, b_first = b.begin() + i * len;
+    fft_inplace(a_first, a_first + len, num_threads);
+    if (!square) {
+      fft_inplace(b_first, b_first + len, num_threads);
+    }
+    const std::size_t chunk = std::min(len, fft_row_length<T>());
+    parallel_for(0, len / chunk, num_threads, [&](std::size_t c) {
+      for (std::size_t j = c * chunk; j < (c + 1) * chunk; j++) {
+        a_first[j] *= b_first[j];
+      }
+    });
+    ifft_inplace(a_first, a_first + len, num_threads);
+  }
+  conv_radix_pass(a, r, len, z, true, num_threads);
+}
+
+// Cyclic convolution of length n, which must be a power of two no less than the lengths of a and b, stored in a.
+template <typename T>
+void conv_cyclic_inplace2(std::vector<T>& a, std::vector<T>& b, std::size_t n, unsigned num_threads) {
+  a.resize(n, T(0));
+  b.resize(n, T(0));
+  if (fft_worth_parallel<T>(n, num_threads)) {
+    unsigned b_threads = num_threads / 2;
+    parallel_invoke([&] { fft_inplace(a, num_threads - b_threads); }, [&] { fft_inplace(b, b_threads); });
+  } else {
+    fft_inplace(a);
+    fft_inplace(b);
+  }
+  conv_transformed_inplace(a, b, num_threads);
+}
+
+template <typename T>
+void conv_fft_inplace2(std::vector<T>& a, std::vector<T>& b, unsigned num_threads) {
+  std::size_t out_size = a.size() + b.size() - 1;
+  if constexpr (odd_radix_fft_root<T>::odd_part > 1) {
+    const ConvFftLength fl = conv_fft_length<T>(out_size);
+    if (fl.radix > 1) {
+      conv_mixed_radix_inplace2(a, b, fl.radix, fl.len, num_threads);
+      a.resize(out_size);
+      return;
+    }
+  }
+  conv_cyclic_inplace2(a, b, port::bit_ceil(out_size), num_threads);
+  a.resize(out_size);
+}
+
 template <typename T>
-void conv_fft_inplace2(std::vector<T>& a, std::vector<T>& b) {
+void square_naive_inplace(std::vector<T>& a) {
+  if (a.empty()) {
+    return;
+  }
   using usize = std::size_t;
-  usize out_size = a.size() + b.size() - 1;
-  usize padded_out_size = port::bit_ceil(out_size);
-  a.resize(padded_out_size, T(0));
-  b.resize(padded_out_size, T(0));
-  fft_inplace(a);
-  fft_inplace(b);
-  for (size_t i = 0; i < padded_out_size; i++) {
-    a[i] *= b[i];
-  }
-  ifft_inplace(a);
+  const usize n = a.size();
+  if constexpr (is_loose_mmint_v<T>) {
+    // Deferred reduction saves more than skipping half of the products.
+    a.resize(n * 2 - 1);
+    conv_naive_lazy(a.data(), n, a.data(), n, a.data());
+    return;
+  }
+  std::vector<T> ret(n * 2 - 1, T(0));
+  for (usize i = 0; i < n; i++) {
+    for (usize j = i + 1; j < n; j++) {
+      ret[i + j] += a[i] * a[j];
+    }
+  }
+  for (usize i = 0; i < n * 2 - 1; i++) {
+    ret[i] += ret[i];
+  }
+  for (usize i = 0; i < n; i++) {
+    ret[i * 2] += a[i] * a[i];
+  }
+  a = std::move(ret);
+}
+
+template <typename T>
+void square_fft_inplace(std::vector<T>& a, unsigned num_threads) {
+  std::size_t out_size = a.size() * 2 - 1;
+  if constexpr (odd_radix_fft_root<T>::odd_part > 1) {
+    const ConvFftLength fl = conv_fft_length<T>(out_size);
+    if (fl.radix > 1) {
+      conv_mixed_radix_inplace2(a, a, fl.radix, fl.len, num_threads);
+      a.resize(out_size);
+      return;
+    }
+  }
+  a.resize(port::bit_ceil(out_size), T(0));
+  fft_inplace(a, num_threads);
+  conv_transformed_inplace(a, a, num_threads);
   a.resize(out_size);
 }
 
+// The t-th coefficient of the product of non-empty a and b.
+template <typename T>
+T conv_coefficient(const std::vector<T>& a, const std::vector<T>& b, std::size_t t) {
+  std::size_t j_low = t < a.size() ? 0 : t - a.size() + 1, j_high = std::min(t, b.size() - 1);
+  T ret(0);
+  for (std::size_t j = j_low; j <= j_high; j++) {
+    ret += a[t - j] * b[j];
+  }
+  return ret;
+}
+
+// Reduces a modulo x^n-1, or x^n+1 if `negacyclic`, into exactly n elements.
+template <typename T>
+std::vector<T> conv_fold(const std::vector<T>& a, std::size_t n, bool negacyclic) {
+  std::vector<T> ret(n, T(0));
+  for (std::size_t i = 0; i < a.size(); i++) {
+    if (negacyclic && i / n % 2 == 1) {
+      ret[i % n] -= a[i];
+    } else {
+      ret[i % n] += a[i];
+    }
+  }
+  return ret;
+}
+
+// Cyclic convolution of a and b with exactly n elements each, stored in a, with transforms of length n if it is a
+// power of two, or r*2^k for an odd radix r supported by T. Returns false if neither is possible.
+template <typename T>
+bool conv_cyclic_exact_inplace2(std::vector<T>& a, std::vector<T>& b, std::size_t n, unsigned num_threads) {
+  if (port::has_single_bit(n) && fft_has_root<T>(port::countr_zero(n))) {
+    conv_cyclic_inplace2(a, b, n, num_threads);
+    return true;
+  }
+  if constexpr (odd_radix_fft_root<T>::odd_part > 1) {
+    const std::size_t r = n >> port::countr_zero(n), len = n / r;
+    if (r <= conv_max_radix && odd_radix_fft_root<T>::odd_part % r == 0 && len >= 64 &&
+        port::countr_zero(len) <= radix2_fft_root<T>::max_log) {
+      conv_mixed_radix_inplace2(a, b, r, len, num_threads);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Convolution by naive multiplication or Karatsuba's algorithm, if either of them is the fastest with thresholds
+// `th`. Returns false otherwise.
+template <typename T>
+bool conv_small_inplace(std::vector<T>& a, const std::vector<T>& b, const ConvThresholds& th) {
+  const std::size_t n = std::min(a.size(), b.size());
+  if (n <= th.naive) {
+    conv_naive_inplace(a, b);
+  } else if (n <= th.karatsuba) {
+    conv_karatsuba_inplace(a, b);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Convolution by conv_small_inplace() or FFT in blocks, if any of them is the fastest. Returns false otherwise, in
+// which case the caller should do FFT on the whole arrays.
+template <typename T>
+bool conv_without_full_fft(std::vector<T>& a, const std::vector<T>& b, unsigned num_threads) {
+  if (conv_small_inplace(a, b, conv_thresholds<T>())) {
+    return true;
+  }
+  if (std::max(a.size(), b.size()) / std::min(a.size(), b.size()) >= conv_split_ratio) {
+    conv_fft_blocked_inplace(a, b, num_threads);
+    return true;
+  }
+  return false;
+}
+
 }  // namespace impl
 
 /**
@@ -62,14 +664,48 @@ void conv_fft_inplace2(std::vector<T>& a, std::vector<T>& b) {
  * `b` is modified in an unspecified way. Use convolve_inplace() if `b` needs to be preserved for later use, or
  * convolve() if both `a` and `b` need to be preserved.
  *
+ * Short arrays are multiplied naively or with Karatsuba's algorithm, and FFT is used otherwise. If one array is much
+ * longer than the other, the longer one is split into blocks a few times the length of the shorter one, and they are
+ * convolved with the same transform of the shorter array. The thresholds are measured for each kind of `T` by the
+ * benchmarks in `test/conv/conv_benchmark.cpp`, which can be run by `./run_tests "[benchmark]"`.
+ *
+ * For ::MMInt and ::MMInt64 with a prime modulus \f$p\f$ where \f$p-1\f$ has a factor \f$r\in\{3,5,7\}\f$, the
+ * transform length can also be \f$r\cdot 2^k\f$ instead of a power of two, which is used when it saves enough padding
+ * to pay for a radix-\f$r\f$ pass before and after transforms of length \f$2^k\f$. For example, \f$754974721=45\cdot
+ * 2^{24}+1\f$ allows \f$3\cdot 2^k\f$ and \f$5\cdot 2^k\f$, so a result of \f$2^{20}+1\f$ terms takes
+ * \f$5\cdot 2^{18}\f$ instead of \f$2^{21}\f$. Such a length is always used if the power of two would be too long,
+ * so the result length can be up to \f$r\cdot 2^n\f$.
+ *
+ * Large convolutions can be split into `num_threads` threads: the transforms of `a` and `b` run concurrently, and each
+ * transform as well as the pointwise product is further parallelized. Convolutions fitting in cache are always done
+ * in the calling thread.
+ *
  * \tparam T See fft_inplace() for requirements for `T`.
  */
 template <typename T>
-void convolve_inplace2(std::vector<T>& a, std::vector<T>& b) {
-  if (impl::conv_naive_is_efficient(a.size(), b.size())) {
-    impl::conv_naive_inplace(a, b);
+void convolve_inplace2(std::vector<T>& a, std::vector<T>& b, unsigned num_threads = 1) {
+  if (!impl::conv_without_full_fft(a, b, num_threads)) {
+    impl::conv_fft_inplace2(a, b, num_threads);
+  }
+}
+
+/**
+ * \brief In-place square of an array, i.e. its convolution with itself.
+ * \ingroup conv
+ *
+ * The result has length `2 * a.size() - 1`, or is empty if `a` is empty. It takes one forward transform instead of two
+ * like convolve_inplace() does, which saves a third of the work.
+ *
+ * \see convolve_inplace2() for other details.
+ */
+template <typename T>
+void square_inplace(std::vector<T>& a, unsigned num_threads = 1) {
+  if (impl::conv_naive_is_efficient<T>(a.size(), a.size())) {
+    impl::square_naive_inplace(a);
+  } else if (a.size() <= impl::conv_thresholds<T>().karatsuba) {
+    impl::conv_karatsuba_inplace(a, a);
   } else {
-    impl::conv_fft_inplace2(a, b);
+    impl::square_fft_inplace(a, num_threads);
   }
 }
 
@@ -77,30 +713,247 @@ void convolve_inplace2(std::vector<T>& a, std::vector<T>& b) {
  * \brief In-place convolution where one array is modified.
  * \ingroup conv
  *
- * The convolution of `a` and `b` is stored in `a`.
+ * The convolution of `a` and `b` is stored in `a`. If `a` and `b` are the same object, this is square_inplace().
  *
  * \see convolve_inplace2() for details
  */
 template <typename T>
-void convolve_inplace(std::vector<T>& a, const std::vector<T>& b) {
-  if (impl::conv_naive_is_efficient(a.size(), b.size())) {
-    impl::conv_naive_inplace(a, b);
-  } else {
+void convolve_inplace(std::vector<T>& a, const std::vector<T>& b, unsigned num_threads = 1) {
+  if (&a == &b) {
+    square_inplace(a, num_threads);
+  } else if (!impl::conv_without_full_fft(a, b, num_threads)) {
     auto b_copy = b;
-    impl::conv_fft_inplace2(a, b_copy);
+    impl::conv_fft_inplace2(a, b_copy, num_threads);
   }
 }
 
 /**
  * \brief Returns the convolution of two arrays.
  * \ingroup conv
+ *
+ * If `a` and `b` are the same object, this is square().
+ *
  * \see convolve_inplace2() for details.
  */
 template <typename T>
-std::vector<T> convolve(const std::vector<T>& a, const std::vector<T>& b) {
+std::vector<T> convolve(const std::vector<T>& a, const std::vector<T>& b, unsigned num_threads = 1) {
   auto a_copy = a;
-  convolve_inplace(a_copy, b);
+  if (&a == &b) {
+    square_inplace(a_copy, num_threads);
+  } else {
+    convolve_inplace(a_copy, b, num_threads);
+  }
   return a_copy;
 }
 
-}  // namespace cplib
\ No newline at end of file
+/**
+ * \brief Returns the convolutions of many pairs of arrays.
+ * \ingroup conv
+ *
+ * Returns `c` with `c[i]` being the convolution of `a[i]` and `b[i]`, where `a` and `b` must have the same length.
+ * This is the same as calling convolve() on each pair, except that the pairs, rather than each transform, are split
+ * into `num_threads` threads, which scales much better for many short arrays. Each thread reuses one buffer for all
+ * its transforms.
+ *
+ * Each pair is multiplied naively, with Karatsuba's algorithm, or with FFT as in convolve_inplace2(), one after
+ * another. Transforms are vectorized only within each pair as in fft_inplace(), not across the batch, so with one
+ * thread this is no faster than calling convolve() in a loop.
+ *
+ * \tparam T See fft_inplace() for requirements for `T`.
+ */
+template <typename T>
+std::vector<std::vector<T>> convolve_batch(const std::vector<std::vector<T>>& a, const std::vector<std::vector<T>>& b,
+                                           unsigned num_threads = 1) {
+  using usize = std::size_t;
+  assert(a.size() == b.size());
+  const usize count = a.size();
+  const impl::ConvThresholds th = impl::conv_thresholds<T>();
+  std::vector<std::vector<T>> ret(count);
+  const usize threads = std::max<usize>(std::min<usize>(num_threads, count), 1);
+  impl::parallel_for(0, threads, unsigned(threads), [&](usize k) {
+    std::vector<T> x, y;
+    for (usize i = count * k / threads; i < count * (k + 1) / threads; i++) {
+      if (a[i].empty() || b[i].empty()) {
+        continue;
+      }
+      if (std::min(a[i].size(), b[i].size()) <= th.karatsuba) {
+        ret[i] = a[i];
+        impl::conv_small_inplace(ret[i], b[i], th);
+        continue;
+      }
+      const usize out_size = a[i].size() + b[i].size() - 1, len = port::bit_ceil(out_size);
+      x.assign(len, T(0));
+      y.assign(len, T(0));
+      std::copy(a[i].begin(), a[i].end(), x.begin());
+      std::copy(b[i].begin(), b[i].end(), y.begin());
+      fft_inplace(x.begin(), x.end());
+      fft_inplace(y.begin(), y.end());
+      for (usize j = 0; j < len; j++) {
+        x[j] *= y[j];
+      }
+      ifft_inplace(x.begin(), x.end());
+      ret[i].assign(x.begin(), x.begin() + out_size);
+    }
+  });
+  return ret;
+}
+
+/**
+ * \brief Returns the square of an array, i.e. its convolution with itself.
+ * \ingroup conv
+ * \see square_inplace() for details.
+ */
+template <typename T>
+std::vector<T> square(const std::vector<T>& a, unsigned num_threads = 1) {
+  auto a_copy = a;
+  square_inplace(a_copy, num_threads);
+  return a_copy;
+}
+
+/**
+ * \brief Returns the first `k` coefficients of the convolution of two arrays.
+ * \ingroup conv
+ *
+ * The result always has length `k`, padded with zeros beyond the full convolution. Only the first `k` elements of `a`
+ * and `b` are used, so the transform length is at most about twice `k` regardless of the input lengths.
+ *
+ * When the product of the used elements is only slightly longer than a power of two no less than `k`, it is computed
+ * as a cyclic convolution of that length, which is half of the usual one, and the few coefficients wrapped around to
+ * the front are corrected by computing them naively, as long as that costs less than a transform.
+ * Otherwise the used elements are convolved as by convolve_inplace2(), including its Karatsuba and blocked tiers.
+ *
+ * \see convolve_inplace2() for other details.
+ */
+template <typename T>
+std::vector<T> convolve_truncated(const std::vector<T>& a, const std::vector<T>& b, std::size_t k,
+                                  unsigned num_threads = 1) {
+  using usize = std::size_t;
+  std::vector<T> a_trunc(a.begin(), a.begin() + std::min(a.size(), k));
+  std::vector<T> b_trunc(b.begin(), b.begin() + std::min(b.size(), k));
+  if (a_trunc.empty() || b_trunc.empty()) {
+    return std::vector<T>(k, T(0));
+  }
+  const usize full = a_trunc.size() + b_trunc.size() - 1, half = port::bit_ceil(full) / 2;
+  const usize wrapped = full - half, out_size = std::min(k, full);
+  if (impl::conv_small_inplace(a_trunc, b_trunc, impl::conv_thresholds<T>())) {
+    // Done by naive multiplication or Karatsuba's algorithm.
+  } else if (out_size <= half &&
+             wrapped * std::min(a_trunc.size(), b_trunc.size()) <= half * port::countr_zero(half)) {
+    std::vector<T> top;
+    for (usize t = half; t < full && t - half < out_size; t++) {
+      top.push_back(impl::conv_coefficient(a_trunc, b_trunc, t));
+    }
+    impl::conv_cyclic_inplace2(a_trunc, b_trunc, half, num_threads);
+    for (usize i = 0; i < top.size(); i++) {
+      a_trunc[i] -= top[i];
+    }
+  } else if (!impl::conv_without_full_fft(a_trunc, b_trunc, num_threads)) {
+    impl::conv_fft_inplace2(a_trunc, b_trunc, num_threads);
+  }
+  a_trunc.resize(k, T(0));
+  return a_trunc;
+}
+
+/**
+ * \brief Returns the middle product of two arrays.
+ * \ingroup conv
+ *
+ * Let \f$n\f$ and \f$m\f$ be the lengths of `a` and `b`, where \f$n\geq m\geq 1\f$ is required, then this returns the
+ * \f$n-m+1\f$ coefficients of the convolution at indices \f$[m-1,n-1]\f$, which are those that involve all elements
+ * of `b`. That is, the \f$i\f$-th element of the result is \f$\sum_{j=0}^{m-1} a_{i+m-1-j}b_j\f$. With `b` reversed,
+ * it is the transposed multiplication \f$\sum_{j=0}^{m-1} a_{i+j}b_j\f$.
+ *
+ * It is computed as a cyclic convolution of length no less than \f$n\f$ instead of \f$n+m-1\f$, since the coefficients
+ * wrapped around only land on the first \f$m-1\f$ ones, which are not needed.
+ *
+ * \see convolve_inplace2() for other details.
+ */
+template <typename T>
+std::vector<T> middle_product(const std::vector<T>& a, const std::vector<T>& b, unsigned num_threads = 1) {
+  using usize = std::size_t;
+  assert(a.size() >= b.size() && !b.empty());
+  const usize n = a.size(), m = b.size(), out_size = n - m + 1;
+  std::vector<T> ret;
+  if (impl::conv_naive_is_efficient<T>(out_size, m)) {
+    ret.reserve(out_size);
+    for (usize i = 0; i < out_size; i++) {
+      T sum(0);
+      for (usize j = 0; j < m; j++) {
+        sum += a[i + m - 1 - j] * b[j];
+      }
+      ret.push_back(sum);
+    }
+    return ret;
+  }
+  std::vector<T> a_copy = a, b_copy = b;
+  impl::conv_cyclic_inplace2(a_copy, b_copy, port::bit_ceil(n), num_threads);
+  ret.assign(a_copy.begin() + (m - 1), a_copy.begin() + n);
+  return ret;
+}
+
+/**
+ * \brief Returns the cyclic convolution of two arrays of length `n`, i.e. their product modulo \f$x^n-1\f$.
+ * \ingroup conv
+ *
+ * The result always has length `n`. Inputs of any length are accepted, and those longer than `n` are reduced modulo
+ * \f$x^n-1\f$ first.
+ *
+ * If `n` is a power of two, or \f$r\cdot 2^k\f$ for an odd radix \f$r\f$ supported by `T` (see convolve_inplace2()),
+ * it is computed with transforms of length exactly `n` instead of the linear convolution of length \f$2n-1\f$, which
+ * halves the work. Otherwise, and for short arrays, it is the linear convolution reduced modulo \f$x^n-1\f$.
+ *
+ * \see convolve_inplace2() for other details.
+ */
+template <typename T>
+std::vector<T> convolve_cyclic(const std::vector<T>& a, const std::vector<T>& b, std::size_t n,
+                               unsigned num_threads = 1) {
+  assert(n > 0);
+  std::vector<T> a_fold = impl::conv_fold(a, n, false), b_fold = impl::conv_fold(b, n, false);
+  if (!impl::conv_naive_is_efficient<T>(n, n) && impl::conv_cyclic_exact_inplace2(a_fold, b_fold, n, num_threads)) {
+    return a_fold;
+  }
+  convolve_inplace2(a_fold, b_fold, num_threads);
+  return impl::conv_fold(a_fold, n, false);
+}
+
+/**
+ * \brief Returns the negacyclic convolution of two arrays of length `n`, i.e. their product modulo \f$x^n+1\f$.
+ * \ingroup conv
+ *
+ * The result always has length `n`. Inputs of any length are accepted, and those longer than `n` are reduced modulo
+ * \f$x^n+1\f$ first.
+ *
+ * If `n` is a power of two and `T` has \f$2n\f$-th root of unity \f$\psi\f$, it is computed with transforms of length
+ * exactly `n`: substituting \f$x=\psi y\f$ turns \f$x^n+1\f$ into \f$-(y^n-1)\f$, so coefficients are twisted by
+ * powers of \f$\psi\f$ before a cyclic convolution, and by those of \f$\psi^{-1}\f$ after. Otherwise, and for short
+ * arrays, it is the linear convolution reduced modulo \f$x^n+1\f$.
+ *
+ * \see convolve_inplace2() for other details.
+ */
+template <typename T>
+std::vector<T> convolve_negacyclic(const std::vector<T>& a, const std::vector<T>& b, std::size_t n,
+                                   unsigned num_threads = 1) {
+  assert(n > 0);
+  std::vector<T> a_fold = impl::conv_fold(a, n, true), b_fold = impl::conv_fold(b, n, true);
+  const int log2n = port::countr_zero(n);
+  if (!port::has_single_bit(n) || !impl::fft_has_root<T>(log2n + 1) || impl::conv_naive_is_efficient<T>(n, n)) {
+    convolve_inplace2(a_fold, b_fold, num_threads);
+    return impl::conv_fold(a_fold, n, true);
+  }
+  // The twiddling factors of the first stage of length 2n are exactly \psi^i for 0<=i<n.
+  const std::vector<T>& psi_pow = impl::FftTwiddleCache<T>::forward(log2n + 1).w;
+  const std::vector<T>& psi_inv_pow = impl::FftTwiddleCache<T>::inverse(log2n + 1).w;
+  for (std::size_t i = 0; i < n; i++) {
+    a_fold[i] *= psi_pow[n + i];
+    b_fold[i] *= psi_pow[n + i];
+  }
+  impl::conv_cyclic_inplace2(a_fold, b_fold, n, num_threads);
+  for (std::size_t i = 0; i < n; i++) {
+    a_fold[i] *= psi_inv_pow[n + i];
+  }
+  return a_fold;
+}
+
+}  // namespace cplib
+
+#pragma GCC pop_options
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "cplib/conv/conv.hpp"
+
+namespace cplib {
+
+namespace impl {
+
+// Returns w^{C(t,2)} for 0<=t<len, where C(t,2)=t(t-1)/2, by C(t,2)=C(t-1,2)+t-1.
+template <typename T>
+std::vector<T> czt_chirp(const T& w, std::size_t len) {
+  std::vector<T> ret(len, T(1));
+  T pw(1);
+  for (std::size_t t = 1; t < len; t++) {
+    ret[t] = ret[t - 1] * pw;
+    pw *= w;
+  }
+  return ret;
+}
+
+// Returns \omega_n^{C(t,2)} for 0<=t<len, or their conjugates if `inverse`, computing each from the exponent modulo n
+// so that the error does not accumulate.
+template <typename Float>
+std::vector<std::complex<Float>> dft_chirp(std::size_t n, std::size_t len, bool inverse) {
+  constexpr long double tau = atanl(1) * 8;
+  std::vector<std::complex<Float>> ret;
+  ret.reserve(len);
+  std::size_t e = 0;
+  for (std::size_t t = 0; t < len; t++) {
+    ret.push_back(std::polar<Float>(1, (inverse ? -tau : tau) * e / n));
+    e = (e + t) % n;
+  }
+  return ret;
+}
+
+// Returns f(a*w^k) for 0<=k<m with Bluestein's algorithm, given chirp[t]=w^{C(t,2)} for t<n+m-1 and
+// inv_chirp[t]=w^{-C(t,2)} for t<max(n,m). Since jk=C(j+k,2)-C(j,2)-C(k,2), the result is
+// w^{-C(k,2)}\sum_j (f_j a^j w^{-C(j,2)}) w^{C(j+k,2)}, which is a middle product with the chirp.
+template <typename T>
+std::vector<T> czt_bluestein(const std::vector<T>& f, const T& a, std::size_t m, const std::vector<T>& chirp,
+                             const std::vector<T>& inv_chirp, unsigned num_threads) {
+  const std::size_t n = f.size();
+  std::vector<T> g(n);
+  T pa(1);
+  for (std::size_t j = 0; j < n; j++) {
+    g[n - 1 - j] = f[j] * pa * inv_chirp[j];
+    pa *= a;
+  }
+  std::vector<T> ret = middle_product(chirp, g, num_threads);
+  for (std::size_t k = 0; k < m; k++) {
+    ret[k] *= inv_chirp[k];
+  }
+  return ret;
+}
+
+}  // namespace impl
+
+/**
+ * \brief Chirp z-transform, i.e. evaluation of a polynomial at a geometric sequence.
+ * \ingroup conv
+ *
+ * Returns \f$f(aw^k)\f$ for \f$0\leq k<m\f$, where \f$f(x)=\sum_j f_jx^j\f$. With \f$a=1\f$ and \f$w\f$ a
+ * primitive \f$n\f$-th root of unity, this is the DFT of any length \f$n\f$, in natural order.
+ *
+ * It is computed with Bluestein's algorithm as one middle product of lengths \f$n+m-1\f$ and \f$n\f$, where \f$n\f$ is
+ * the length of `f`, thus takes \f$O((n+m)\log(n+m))\f$ time. Short inputs are evaluated naively. `w` must be
+ * invertible.
+ *
+ * For complex numbers, powers of `w` are computed by repeated multiplication, so the error grows with \f$n+m\f$. Use
+ * dft() for roots of unity, which computes them accurately.
+ *
+ * \tparam T See fft_inplace() for requirements for `T`.
+ */
+template <typename T>
+std::vector<T> czt(const std::vector<T>& f, const T& w, std::size_t m, const T& a = T(1), unsigned num_threads = 1) {
+  if (f.empty() || m == 0) {
+    return std::vector<T>(m, T(0));
+  }
+  if (impl::conv_naive_is_efficient<T>(f.size(), m)) {
+    std::vector<T> ret(m);
+    T x = a;
+    for (std::size_t k = 0; k < m; k++) {
+      T y(0);
+      for (std::size_t j = f.size(); j-- > 0;) {
+        y = y * x + f[j];
+      }
+      ret[k] = y;
+      x *= w;
+    }
+    return ret;
+  }
+  const std::size_t n = f.size();
+  const T w_inv = T(1) / w;
+  return impl::czt_bluestein(f, a, m, impl::czt_chirp(w, n + m - 1), impl::czt_chirp(w_inv, std::max(n, m)),
+                             num_threads);
+}
+
+/**
+ * \brief Discrete Fourier transform of any length.
+ * \ingroup conv
+ *
+ * Returns \f$X_k=\sum_j x_j\omega_n^{jk}\f$ for \f$0\leq k<n\f$ in natural order, where \f$n\f$ is the length of `x`
+ * and \f$\omega_n=e^{2\pi i/n}\f$ is the same root as that of fft_inplace(). It is computed with Bluestein's algorithm
+ * (see czt()) in \f$O(n\log n)\f$ time, with the chirp computed from exponents modulo \f$n\f$ so that the error is
+ * about the same as that of fft_inplace().
+ *
+ * For power-of-two lengths, fft_inplace() is several times faster.
+ */
+template <typename Float>
+std::vector<std::complex<Float>> dft(const std::vector<std::complex<Float>>& x, unsigned num_threads = 1) {
+  const std::size_t n = x.size();
+  if (n == 0) {
+    return {};
+  }
+  return impl::czt_bluestein(x, std::complex<Float>(1), n, impl::dft_chirp<Float>(n, n * 2 - 1, false),
+                             impl::dft_chirp<Float>(n, n, true), num_threads);
+}
+
+/**
+ * \brief Inverse discrete Fourier transform of any length.
+ * \ingroup conv
+ *
+ * Undoes dft() up to rounding errors, i.e. returns \f$x_j=\frac{1}{n}\sum_k X_k\omega_n^{-jk}\f$.
+ */
+template <typename Float>
+std::vector<std::complex<Float>> idft(const std::vector<std::complex<Float>>& x, unsigned num_threads = 1) {
+  const std::size_t n = x.size();
+  if (n == 0) {
+    return {};
+  }
+  std::vector<std::complex<Float>> ret = impl::czt_bluestein(
+      x, std::complex<Float>(1), n, impl::dft_chirp<Float>(n, n * 2 - 1, true), impl::dft_chirp<Float>(n, n, false),
+      num_threads);
+  for (auto& v : ret) {
+    v /= Float(n);
+  }
+  return ret;
+}
+
+}  // namespace cplib
@@ -1,13 +1,31 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <cmath>
 #include <complex>
+#include <cstring>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <type_traits>
 #include <vector>
 
 #include "cplib/num/mmint.hpp"
+#include "cplib/num/mmint_avx2.hpp"
 #include "cplib/num/pow.hpp"
+#include "cplib/num/primitive_root_constexpr.hpp"
 #include "cplib/port/bit.hpp"
+#include "cplib/utils/parallel.hpp"
+#include "cplib/utils/type.hpp"
+
+#pragma GCC push_options
+#ifndef _CPLIB_NO_FORCE_AVX2_
+#pragma GCC target("avx2")
+#endif
 
 namespace cplib {
 
@@ -37,7 +55,7 @@ std::vector<T> twiddling_factors(const std::vector<T>& roots) {
 /**
  * \brief \f$2^n\f$-th root of unity for radix-2 FFT.
  * \ingroup conv
- * \see radix2_fft_root<MMInt<998244353>>, radix2_fft_root<MMInt64<4512606826625236993>>,
+ * \see radix2_fft_root<MontgomeryModInt<impl::StaticMontgomeryReductionContext<UInt, Mod>>>,
  * radix2_fft_root<std::complex<Float>>
  *
  * Specialization of this class must provide a method `static T get(int n)` that returns the \f$2^n\f$-th root of unity.
@@ -55,29 +73,46 @@ template <typename T>
 struct radix2_fft_root {};
 
 /**
- * \brief Specialization of radix2_fft_root for \f$\mathbb{F}_{998244353}\f$, the most common FFT-friendly
- * finite prime field in competitive programming.
+ * \brief Specialization of radix2_fft_root for MontgomeryModInt with a compile-time prime modulus.
  *
- * Since \f$998244353=119\cdot 2^{23}+1\f$, \f$2^n\f$-th root of unity exists for \f$0\leq n \leq 23\f$.
- */
-template <>
-struct radix2_fft_root<MMInt<998244353>> {
-  using mint = MMInt<998244353>;
-  static mint get(int n) { return pow(mint(3), 119 << (23 - n)); }
-};
-
-/**
- * \brief Specialization of radix2_fft_root for a large FFT-friendly finite prime field.
+ * For a prime \f$p=c\cdot 2^k+1\f$ with odd \f$c\f$, \f$2^n\f$-th root of unity exists for \f$0\leq n\leq k\f$,
+ * where \f$k\f$ is `max_log`. The roots are powers of the smallest primitive root (see
+ * primitive_root_prime_constexpr()), and are all computed at compile time, so any FFT-friendly prime works without
+ * setup cost. Common ones include:
  *
- * Since \f$p=4512606826625236993=501\cdot 2^{53}+1\f$, \f$2^n\f$-th root of unity exists for \f$0\leq n \leq 53\f$.
+ * - \f$998244353=119\cdot 2^{23}+1\f$, the most common one in competitive programming.
+ * - \f$167772161=5\cdot 2^{25}+1\f$, \f$469762049=7\cdot 2^{26}+1\f$ and \f$754974721=45\cdot 2^{24}+1\f$, whose
+ *   product exceeds \f$2^{86}\f$.
+ * - \f$4512606826625236993=501\cdot 2^{53}+1\f$, which is useful for convolution over \f$\mathbb{Z}\f$ where all
+ *   terms in the result are bounded by a range smaller than \f$p\approx 4.5\times 10^{18}\f$, so the value modulo
+ *   \f$p\f$ uniquely determines the value in \f$\mathbb{Z}\f$.
  *
- * This is useful for convolution over \f$\mathbb{Z}\f$ where all terms in the result are bounded by a range smaller
- * than \f$p\approx 4.5\times 10^{18}\f$, so the value modulo \f$p\f$ uniquely determines the value in \f$\mathbb{Z}\f$.
+ * The modulus must be a prime, otherwise the behavior is undefined.
  */
-template <>
-struct radix2_fft_root<MMInt64<4512606826625236993>> {
-  using mint = MMInt64<4512606826625236993>;
-  static mint get(int n) { return pow(mint(7), 501ull << (53 - n)); }
+template <typename UInt, UInt Mod>
+struct radix2_fft_root<MontgomeryModInt<impl::StaticMontgomeryReductionContext<UInt, Mod>>> {
+  using mint = MontgomeryModInt<impl::StaticMontgomeryReductionContext<UInt, Mod>>;
+  static constexpr int max_log = port::countr_zero(UInt(Mod - 1));
+
+  static constexpr mint get(int n) {
+    assert(0 <= n && n <= max_log);
+    return mint::from_raw(roots_[n]);
+  }
+
+ private:
+  // Raw values in Montgomery form of the 2^n-th roots.
+  static constexpr std::array<UInt, max_log + 1> roots_ = [] {
+    using U = impl::make_double_width_t<UInt>;
+    std::array<UInt, max_log + 1> ret{};
+    const UInt g = primitive_root_prime_constexpr(Mod);
+    UInt w = impl::pow_mod_constexpr<UInt>(g, (Mod - 1) >> max_log, Mod);
+    const auto& mr = impl::StaticMontgomeryReductionContext<UInt, Mod>::montgomery_reduction();
+    for (int n = max_log; n >= 0; n--) {
+      ret[n] = mr.mul(w, mr.mbase2());
+      w = UInt(U(w) * w % Mod);
+    }
+    return ret;
+  }();
 };
 
 /**
@@ -93,6 +128,707 @@ struct radix2_fft_root<std::complex<Float>> {
   }
 };
 
+namespace impl {
+
+// Whether T is a MontgomeryModInt with N<R/4, whose values can float in [0,4N) between FFT stages.
+template <typename T>
+struct is_loose_mmint : std::false_type {};
+
+template <typename Context>
+struct is_loose_mmint<MontgomeryModInt<Context>>
+    : std::is_same<typename Context::mr_type, MontgomeryReductionLoose<typename Context::int_type>> {};
+
+template <typename T>
+constexpr bool is_loose_mmint_v = is_loose_mmint<T>::value;
+
+// Twiddling factor for Shoup's multiplication, which is cheaper than Montgomery multiplication by a constant.
+//
+// For w in [0,N) and q=floor(w*R/N), x*w-hi(x*q)*N is x*w mod N plus 0 or N for any x<R, and can be computed with
+// the low halves of the products. The twiddling factor is stored as its plain value, so that multiplying a raw value
+// in Montgomery form gives the product in Montgomery form in [0,2N).
+template <typename T, typename = void>
+struct ShoupTwiddle {};
+
+template <typename T>
+struct ShoupTwiddle<T, std::enable_if_t<is_loose_mmint_v<T>>> {
+  using int_type = typename T::int_type;
+  using int_double_t = typename T::int_double_t;
+  int_type w, q;
+
+  ShoupTwiddle() = default;
+
+  explicit ShoupTwiddle(const T& x)
+      : w(x.val()), q((int_double_t(w) << std::numeric_limits<int_type>::digits) / T::mod()) {}
+
+  T mul(int_type x) const {
+    int_type hi = (int_double_t(x) * q) >> std::numeric_limits<int_type>::digits;
+    return T::from_raw(x * w - hi * T::mod());
+  }
+};
+
+// Twiddling factors of all FFT stages up to some length, for one direction.
+//
+// The stage pairing elements 2^k apart uses \omega_{2^{k+1}}^i for 0<=i<2^k, which is stored in w at [2^k,2^{k+1}),
+// thus each stage reads a contiguous slice. Radix-4 butterflies merging that stage with the next one additionally use
+// \omega_{2^{k+1}}^{3i} for 0<=i<2^{k-1}, which is stored in w3 at [2^{k-1},2^k).
+//
+// For MontgomeryModInt with N<R/4, they are stored in [0,N) as required by FftLazyKernel, and for 64-bit modulus
+// additionally in w_shoup and w3_shoup with the same layout for Shoup's multiplication.
+template <typename T>
+struct FftTwiddleTable {
+  std::vector<T> roots, w, w3;
+  std::vector<ShoupTwiddle<T>> w_shoup, w3_shoup;
+
+  // Appends twiddling factors of the stage with the given root, which must be the square root of the last one.
+  void extend(const T& root) {
+    roots.push_back(root);
+    std::vector<T> level = twiddling_factors(roots);
+    std::size_t len = level.size();
+    w.resize(len * 2);
+    std::copy(level.begin(), level.end(), w.begin() + len);
+    if (len >= 2) {
+      w3.resize(len);
+      for (std::size_t i = 0; i < len / 2; i++) {
+        w3[len / 2 + i] = level[i] * level[i * 2];
+      }
+    }
+    if constexpr (is_loose_mmint_v<T>) {
+      for (std::size_t i = len; i < len * 2; i++) {
+        w[i] = T::from_raw(w[i].residue());
+      }
+      for (std::size_t i = len / 2; i < w3.size(); i++) {
+        w3[i] = T::from_raw(w3[i].residue());
+      }
+      if constexpr (sizeof(T) > sizeof(uint32_t)) {
+        w_shoup.resize(w.size());
+        w3_shoup.resize(w3.size());
+        for (std::size_t i = len; i < len * 2; i++) {
+          w_shoup[i] = ShoupTwiddle<T>(w[i]);
+        }
+        for (std::size_t i = len / 2; i < w3.size(); i++) {
+          w3_shoup[i] = ShoupTwiddle<T>(w3[i]);
+        }
+      }
+    }
+  }
+};
+
+// Process-wide cache of twiddling factors for all FFTs over T, so that repeated transforms only pay for a lookup.
+// A table for length 2^L serves all lengths up to 2^L.
+//
+// Lookups are lock-free, and growth is serialized by a mutex. A grown table is built as a new copy and published
+// atomically, while older ones are kept alive until the program exits, as transforms in other threads may still be
+// reading them. Since each table is at least twice as large as the previous one, this at most doubles the memory.
+template <typename T>
+class FftTwiddleCache {
+ public:
+  using table_type = FftTwiddleTable<T>;
+
+  static const table_type& forward(int log2n) { return get(log2n).forward; }
+
+  static const table_type& inverse(int log2n) { return get(log2n).inverse; }
+
+  static void reserve(int log2n) { get(log2n); }
+
+ private:
+  struct Tables {
+    int log2n;
+    table_type forward, inverse;
+  };
+
+  static inline std::mutex mutex_;
+  static inline std::atomic<const Tables*> current_{nullptr};
+  static inline std::vector<std::unique_ptr<Tables>> tables_;
+
+  static const Tables& get(int log2n) {
+    const Tables* cur = current_.load(std::memory_order_acquire);
+    if (cur != nullptr && log2n <= cur->log2n) {
+      return *cur;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    cur = current_.load(std::memory_order_relaxed);
+    if (cur != nullptr && log2n <= cur->log2n) {
+      return *cur;
+    }
+    auto next = std::make_unique<Tables>();
+    const T one = radix2_fft_root<T>::get(0);
+    if (cur != nullptr) {
+      *next = *cur;
+    } else {
+      next->log2n = 0;
+      next->forward.roots.push_back(one);
+      next->inverse.roots.push_back(one);
+    }
+    for (int k = next->log2n; k < log2n; k++) {
+      T root = radix2_fft_root<T>::get(k + 1);
+      next->forward.extend(root);
+      next->inverse.extend(one / root);
+    }
+    next->log2n = log2n;
+    cur = next.get();
+    tables_.push_back(std::move(next));
+    current_.store(cur, std::memory_order_release);
+    return *cur;
+  }
+};
+
+template <typename It>
+constexpr bool is_contiguous_iterator_v =
+    std::is_pointer_v<It> ||
+    std::is_same_v<It, typename std::vector<typename std::iterator_traits<It>::value_type>::iterator>;
+
+// Butterflies of FFT stages, applied to `len` pairs (x[i],y[i]) with twiddling factors w[i]. Forward transform uses
+// decimation-in-frequency butterflies and inverse transform uses decimation-in-time ones, so that neither needs a
+// bit-reversal permutation.
+//
+// Radix-4 butterflies do the same as two consecutive radix-2 stages, on `len` quadruples (x[i+k*stride]) for k=0,1,2,3
+// with twiddling factors w1[i], w2[i]=w1[i]^2, w3[i]=w1[i]^3, and the 4th root of unity `imag`, thus only read and
+// write each element once for every two stages.
+//
+// A kernel may additionally fuse the last `fused_stages` stages of forward transform (the first ones of inverse
+// transform), which only work within blocks of 2^fused_stages elements, into forward_fused() and inverse_fused().
+//
+// The twiddling factors passed to the butterflies are those returned by twiddles() and twiddles3() from the table,
+// which are indexed the same as FftTwiddleTable::w and FftTwiddleTable::w3 but may be stored differently.
+template <typename T>
+struct FftScalarKernel {
+  static constexpr int fused_stages = 0;
+
+  static const T* twiddles(const FftTwiddleTable<T>& table) { return table.w.data(); }
+
+  static const T* twiddles3(const FftTwiddleTable<T>& table) { return table.w3.data(); }
+
+  template <typename It>
+  static void forward(It x, It y, const T* w, std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+      T tmp = (x[i] - y[i]) * w[i];
+      x[i] += y[i];
+      y[i] = tmp;
+    }
+  }
+
+  template <typename It>
+  static void inverse(It x, It y, const T* w, std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+      y[i] *= w[i];
+      T tmp = x[i] - y[i];
+      x[i] += y[i];
+      y[i] = tmp;
+    }
+  }
+
+  template <typename It>
+  static void forward4(It x, std::size_t stride, const T* w1, const T* w2, const T* w3, const T& imag,
+                       std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+      T a0 = x[i], a1 = x[i + stride], a2 = x[i + stride * 2], a3 = x[i + stride * 3];
+      T t0 = a0 + a2, t1 = a1 + a3, t2 = a0 - a2, t3 = (a1 - a3) * imag;
+      x[i] = t0 + t1;
+      x[i + stride] = (t0 - t1) * w2[i];
+      x[i + stride * 2] = (t2 + t3) * w1[i];
+      x[i + stride * 3] = (t2 - t3) * w3[i];
+    }
+  }
+
+  template <typename It>
+  static void inverse4(It x, std::size_t stride, const T* w1, const T* w2, const T* w3, const T& imag,
+                       std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+      T a0 = x[i], a1 = x[i + stride] * w2[i], a2 = x[i + stride * 2] * w1[i], a3 = x[i + stride * 3] * w3[i];
+      T t0 = a0 + a1, t1 = a0 - a1, t2 = a2 + a3, t3 = (a2 - a3) * imag;
+      x[i] = t0 + t2;
+      x[i + stride] = t1 + t3;
+      x[i + stride * 2] = t0 - t2;
+      x[i + stride * 3] = t1 - t3;
+    }
+  }
+
+  template <typename It>
+  static void forward_fused(It, std::size_t, const T*) {}
+
+  template <typename It>
+  static void inverse_fused(It, std::size_t, const T*) {}
+
+  template <typename It>
+  static void scale(It first, std::size_t n, const T& c) {
+    for (std::size_t i = 0; i < n; i++) {
+      first[i] *= c;
+    }
+  }
+};
+
+// Butterflies with lazy reduction for MontgomeryModInt with N<R/4, following Harvey's NTT, on raw values.
+//
+// Forward transform keeps values in [0,2N). x+y is reduced, but x-y+2N is in [0,4N) and directly multiplied by the
+// twiddling factor in [0,N), which gives a result in [0,2N) without reduction. Inverse transform lets values float in
+// [0,4N) instead: only x is reduced to [0,2N) before computing x+y*w and x-y*w+2N, and scale() brings values back to
+// [0,2N). This halves the number of conditional reductions compared with FftScalarKernel.
+//
+// Twiddling factors of 64-bit modulus are multiplied with Shoup's multiplication, which saves one 64x64->128
+// multiplication. For 32-bit modulus it takes as many multiplications as Montgomery multiplication but twice the
+// memory, so twiddling factors are used as T in [0,N). The butterflies accept both.
+template <typename T>
+struct FftLazyKernel {
+  using int_type = typename T::int_type;
+  using twiddle_type = std::conditional_t<(sizeof(T) > sizeof(uint32_t)), ShoupTwiddle<T>, T>;
+  static constexpr int fused_stages = 0;
+
+  static const twiddle_type* twiddles(const FftTwiddleTable<T>& table) {
+    if constexpr (std::is_same_v<twiddle_type, T>) {
+      return table.w.data();
+    } else {
+      return table.w_shoup.data();
+    }
+  }
+
+  static const twiddle_type* twiddles3(const FftTwiddleTable<T>& table) {
+    if constexpr (std::is_same_v<twiddle_type, T>) {
+      return table.w3.data();
+    } else {
+      return table.w3_shoup.data();
+    }
+  }
+
+  template <typename It, typename W>
+  static void forward(It x, It y, const W* w, std::size_t len) {
+    const int_type mod2 = T::mod() * 2;
+    for (std::size_t i = 0; i < len; i++) {
+      int_type a = x[i].raw(), b = y[i].raw();
+      x[i] = T::from_raw(reduce(a + b, mod2));
+      y[i] = mul(a - b + mod2, w[i]);
+    }
+  }
+
+  template <typename It, typename W>
+  static void inverse(It x, It y, const W* w, std::size_t len) {
+    const int_type mod2 = T::mod() * 2;
+    for (std::size_t i = 0; i < len; i++) {
+      int_type a = reduce(x[i].raw(), mod2), b = mul(y[i].raw(), w[i]).raw();
+      x[i] = T::from_raw(a + b);
+      y[i] = T::from_raw(a - b + mod2);
+    }
+  }
+
+  template <typename It, typename W>
+  static void forward4(It x, std::size_t stride, const W* w1, const W* w2, const W* w3, const W& imag,
+                       std::size_t len) {
+    const int_type mod2 = T::mod() * 2;
+    for (std::size_t i = 0; i < len; i++) {
+      int_type a0 = x[i].raw(), a1 = x[i + stride].raw(), a2 = x[i + stride * 2].raw(), a3 = x[i + stride * 3].raw();
+      int_type t0 = reduce(a0 + a2, mod2), t1 = reduce(a1 + a3, mod2), t2 = reduce(a0 - a2 + mod2, mod2);
+      int_type t3 = mul(a1 - a3 + mod2, imag).raw();
+      x[i] = T::from_raw(reduce(t0 + t1, mod2));
+      x[i + stride] = mul(t0 - t1 + mod2, w2[i]);
+      x[i + stride * 2] = mul(t2 + t3, w1[i]);
+      x[i + stride * 3] = mul(t2 - t3 + mod2, w3[i]);
+    }
+  }
+
+  template <typename It, typename W>
+  static void inverse4(It x, std::size_t stride, const W* w1, const W* w2, const W* w3, const W& imag,
+                       std::size_t len) {
+    const int_type mod2 = T::mod() * 2;
+    for (std::size_t i = 0; i < len; i++) {
+      int_type a0 = reduce(x[i].raw(), mod2), a1 = mul(x[i + stride].raw(), w2[i]).raw();
+      int_type a2 = mul(x[i + stride * 2].raw(), w1[i]).raw(), a3 = mul(x[i + stride * 3].raw(), w3[i]).raw();
+      int_type t0 = reduce(a0 + a1, mod2), t1 = reduce(a0 - a1 + mod2, mod2), t2 = reduce(a2 + a3, mod2);
+      int_type t3 = mul(a2 - a3 + mod2, imag).raw();
+      x[i] = T::from_raw(t0 + t2);
+      x[i + stride] = T::from_raw(t1 + t3);
+      x[i + stride * 2] = T::from_raw(t0 - t2 + mod2);
+      x[i + stride * 3] = T::from_raw(t1 - t3 + mod2);
+    }
+  }
+
+  template <typename It, typename W>
+  static void forward_fused(It, std::size_t, const W*) {}
+
+  template <typename It, typename W>
+  static void inverse_fused(It, std::size_t, const W*) {}
+
+  // Also reduces values from [0,4N) to [0,2N).
+  template <typename It>
+  static void scale(It first, std::size_t n, const T& c) {
+    const ShoupTwiddle<T> c_shoup(c);
+    for (std::size_t i = 0; i < n; i++) {
+      first[i] = c_shoup.mul(first[i].raw());
+    }
+  }
+
+  // From [0,4N) to [0,2N), where x-2N wraps around if x<2N. Written as a minimum so that it is never a branch.
+  static int_type reduce(int_type x, int_type mod2) { return std::min(x, x - mod2); }
+
+  // x*w in [0,2N) for x in [0,4N).
+  static T mul(int_type x, const ShoupTwiddle<T>& w) { return w.mul(x); }
+
+  static T mul(int_type x, const T& w) { return T::from_raw(x) * w; }
+};
+
+// Same as FftScalarKernel for std::complex, but multiplies without the checks for infinity and NaN that operator*
+// does, which are useless for finite inputs and prevent vectorization.
+template <typename T>
+struct FftComplexKernel : FftScalarKernel<T> {
+  template <typename It>
+  static void forward(It x, It y, const T* w, std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+      T tmp = mul(x[i] - y[i], w[i]);
+      x[i] += y[i];
+      y[i] = tmp;
+    }
+  }
+
+  template <typename It>
+  static void inverse(It x, It y, const T* w, std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+      T b = mul(y[i], w[i]);
+      y[i] = x[i] - b;
+      x[i] += b;
+    }
+  }
+
+  template <typename It>
+  static void forward4(It x, std::size_t stride, const T* w1, const T* w2, const T* w3, const T& imag,
+                       std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+      T a0 = x[i], a1 = x[i + stride], a2 = x[i + stride * 2], a3 = x[i + stride * 3];
+      T t0 = a0 + a2, t1 = a1 + a3, t2 = a0 - a2, t3 = mul(a1 - a3, imag);
+      x[i] = t0 + t1;
+      x[i + stride] = mul(t0 - t1, w2[i]);
+      x[i + stride * 2] = mul(t2 + t3, w1[i]);
+      x[i + stride * 3] = mul(t2 - t3, w3[i]);
+    }
+  }
+
+  template <typename It>
+  static void inverse4(It x, std::size_t stride, const T* w1, const T* w2, const T* w3, const T& imag,
+                       std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+      T a0 = x[i], a1 = mul(x[i + stride], w2[i]), a2 = mul(x[i + stride * 2], w1[i]),
+        a3 = mul(x[i + stride * 3], w3[i]);
+      T t0 = a0 + a1, t1 = a0 - a1, t2 = a2 + a3, t3 = mul(a2 - a3, imag);
+      x[i] = t0 + t2;
+      x[i + stride] = t1 + t3;
+      x[i + stride * 2] = t0 - t2;
+      x[i + stride * 3] = t1 - t3;
+    }
+  }
+
+ private:
+  static T mul(const T& a, const T& b) {
+    return T(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+  }
+};
+
+// The kernel for T used when elements may not be contiguous in memory.
+template <typename T, typename = void>
+struct fft_generic_kernel {
+  using type = FftScalarKernel<T>;
+};
+
+template <typename Float>
+struct fft_generic_kernel<std::complex<Float>> {
+  using type = FftComplexKernel<std::complex<Float>>;
+};
+
+template <typename T>
+struct fft_generic_kernel<T, std::enable_if_t<is_loose_mmint_v<T>>> {
+  using type = FftLazyKernel<T>;
+};
+
+#if defined(__AVX2__) || !defined(_CPLIB_NO_FORCE_AVX2_)
+
+// Processes 8 butterflies at a time with MMIntx8, with the same lazy reduction as FftLazyKernel. Stages with fewer
+// than 8 butterflies per block are fused, and done with in-register shuffles on each block of 8 elements, where
+// values are kept in [0,2N).
+template <uint32_t Mod>
+struct FftAvx2Kernel {
+  using mint = MMInt<Mod>;
+  using mintx8 = MMIntx8<Mod>;
+  using Scalar = FftLazyKernel<mint>;
+  static constexpr int fused_stages = 3;
+
+  // Shoup's multiplication takes as many multiplications as Montgomery multiplication in AVX2, since there is no
+  // 32x32->32 multiplication cheaper than 32x32->64 ones, and twice the memory for twiddling factors.
+  static const mint* twiddles(const FftTwiddleTable<mint>& table) { return table.w.data(); }
+
+  static const mint* twiddles3(const FftTwiddleTable<mint>& table) { return table.w3.data(); }
+
+  static void forward(mint* x, mint* y, const mint* w, std::size_t len) {
+    std::size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+      mintx8 a = mintx8::load(x + i), b = mintx8::load(y + i);
+      (a + b).store(x + i);
+      (sub_lazy(a, b) * mintx8::load(w + i)).store(y + i);
+    }
+    Scalar::forward(x + i, y + i, w + i, len - i);
+  }
+
+  static void inverse(mint* x, mint* y, const mint* w, std::size_t len) {
+    std::size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+      mintx8 a = reduce(mintx8::load(x + i)), b = mintx8::load(y + i) * mintx8::load(w + i);
+      add_lazy(a, b).store(x + i);
+      sub_lazy(a, b).store(y + i);
+    }
+    Scalar::inverse(x + i, y + i, w + i, len - i);
+  }
+
+  // Radix-4 butterflies are only called with len being a multiple of 8.
+  static void forward4(mint* x, std::size_t stride, const mint* w1, const mint* w2, const mint* w3, const mint& imag,
+                       std::size_t len) {
+    const mintx8 imag8(imag);
+    for (std::size_t i = 0; i < len; i += 8) {
+      mintx8 a0 = mintx8::load(x + i), a1 = mintx8::load(x + i + stride);
+      mintx8 a2 = mintx8::load(x + i + stride * 2), a3 = mintx8::load(x + i + stride * 3);
+      mintx8 t0 = a0 + a2, t1 = a1 + a3, t2 = a0 - a2, t3 = sub_lazy(a1, a3) * imag8;
+      (t0 + t1).store(x + i);
+      (sub_lazy(t0, t1) * mintx8::load(w2 + i)).store(x + i + stride);
+      (add_lazy(t2, t3) * mintx8::load(w1 + i)).store(x + i + stride * 2);
+      (sub_lazy(t2, t3) * mintx8::load(w3 + i)).store(x + i + stride * 3);
+    }
+  }
+
+  static void inverse4(mint* x, std::size_t stride, const mint* w1, const mint* w2, const mint* w3, const mint& imag,
+                       std::size_t len) {
+    const mintx8 imag8(imag);
+    for (std::size_t i = 0; i < len; i += 8) {
+      mintx8 a0 = reduce(mintx8::load(x + i)), a1 = mintx8::load(x + i + stride) * mintx8::load(w2 + i);
+      mintx8 a2 = mintx8::load(x + i + stride * 2) * mintx8::load(w1 + i);
+      mintx8 a3 = mintx8::load(x + i + stride * 3) * mintx8::load(w3 + i);
+      mintx8 t0 = a0 + a1, t1 = a0 - a1, t2 = a2 + a3, t3 = sub_lazy(a2, a3) * imag8;
+      add_lazy(t0, t2).store(x + i);
+      add_lazy(t1, t3).store(x + i + stride);
+      sub_lazy(t0, t2).store(x + i + stride * 2);
+      sub_lazy(t1, t3).store(x + i + stride * 3);
+    }
+  }
+
+  // In each stage, every lane is paired with the lane given by the shuffle. The lanes holding the first element of a
+  // pair become x+y, and the others, where the shuffled value is x, become x-y.
+  static void forward_fused(mint* first, std::size_t n, const mint* twiddles) {
+    const mintx8 w4 = twiddle4(twiddles), w2 = twiddle2(twiddles);
+    for (std::size_t i = 0; i < n; i += 8) {
+      mintx8 v = mintx8::load(first + i), u;
+      u = mintx8(_mm256_permute4x64_epi64(v.data(), 0b01001110));
+      v = mintx8(_mm256_blend_epi32((v + u).data(), ((u - v) * w4).data(), 0b11110000));
+      u = mintx8(_mm256_shuffle_epi32(v.data(), 0b01001110));
+      v = mintx8(_mm256_blend_epi32((v + u).data(), ((u - v) * w2).data(), 0b11001100));
+      u = mintx8(_mm256_shuffle_epi32(v.data(), 0b10110001));
+      v = mintx8(_mm256_blend_epi32((v + u).data(), (u - v).data(), 0b10101010));
+      v.store(first + i);
+    }
+  }
+
+  static void inverse_fused(mint* first, std::size_t n, const mint* twiddles) {
+    const mintx8 w4 = twiddle4(twiddles), w2 = twiddle2(twiddles), one(twiddles[1]);
+    const mintx8 y_w4(_mm256_blend_epi32(one.data(), w4.data(), 0b11110000));
+    const mintx8 y_w2(_mm256_blend_epi32(one.data(), w2.data(), 0b11001100));
+    for (std::size_t i = 0; i < n; i += 8) {
+      mintx8 v = mintx8::load(first + i), u;
+      u = mintx8(_mm256_shuffle_epi32(v.data(), 0b10110001));
+      v = mintx8(_mm256_blend_epi32((v + u).data(), (u - v).data(), 0b10101010));
+      v *= y_w2;
+      u = mintx8(_mm256_shuffle_epi32(v.data(), 0b01001110));
+      v = mintx8(_mm256_blend_epi32((v + u).data(), (u - v).data(), 0b11001100));
+      v *= y_w4;
+      u = mintx8(_mm256_permute4x64_epi64(v.data(), 0b01001110));
+      v = mintx8(_mm256_blend_epi32((v + u).data(), (u - v).data(), 0b11110000));
+      v.store(first + i);
+    }
+  }
+
+  static void scale(mint* first, std::size_t n, const mint& c) {
+    const mintx8 c8(mint::from_raw(c.residue()));
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      (mintx8::load(first + i) * c8).store(first + i);
+    }
+    Scalar::scale(first + i, n - i, c);
+  }
+
+ private:
+  // From [0,4N) to [0,2N).
+  static mintx8 reduce(const mintx8& a) {
+    return mintx8(_mm256_min_epu32(a.data(), _mm256_sub_epi32(a.data(), _mm256_set1_epi32(Mod * 2))));
+  }
+
+  // a+b in [0,4N) for a,b in [0,2N).
+  static mintx8 add_lazy(const mintx8& a, const mintx8& b) { return mintx8(_mm256_add_epi32(a.data(), b.data())); }
+
+  // a-b+2N in [0,4N) for a,b in [0,2N).
+  static mintx8 sub_lazy(const mintx8& a, const mintx8& b) {
+    return mintx8(_mm256_add_epi32(_mm256_sub_epi32(a.data(), b.data()), _mm256_set1_epi32(Mod * 2)));
+  }
+
+  // Twiddling factors of the stage with 4 butterflies per block, repeated twice.
+  static mintx8 twiddle4(const mint* twiddles) {
+    return mintx8(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(twiddles + 4))));
+  }
+
+  // Twiddling factors of the stage with 2 butterflies per block, repeated 4 times.
+  static mintx8 twiddle2(const mint* twiddles) {
+    long long w;
+    std::memcpy(&w, twiddles + 2, sizeof(w));
+    return mintx8(_mm256_set1_epi64x(w));
+  }
+};
+
+#endif
+
+// The fastest kernel for T, which is used when elements are contiguous in memory.
+template <typename T, typename = void>
+struct fft_kernel {
+  using type = typename fft_generic_kernel<T>::type;
+};
+
+#if defined(__AVX2__) || !defined(_CPLIB_NO_FORCE_AVX2_)
+template <uint32_t Mod>
+struct fft_kernel<MMInt<Mod>, std::enable_if_t<(Mod <= std::numeric_limits<uint32_t>::max() / 4)>> {
+  using type = FftAvx2Kernel<Mod>;
+};
+#endif
+
+// Transforms of more than this many bytes are done in a cache-blocked "four-step" manner. The array is viewed as a
+// matrix with rows of fft_row_length() elements. Stages pairing elements in different rows are first done on a few
+// columns at a time, which is a transform of each column followed by the twiddling multiplication, merged into
+// the butterflies. The remaining stages work within each row and are done row by row. Both phases only sweep the
+// array once, instead of once every two stages, and the output is exactly the same as the plain transform.
+constexpr std::size_t fft_cache_bytes = std::size_t(1) << 18;
+
+template <typename T>
+constexpr std::size_t fft_row_length() {
+  return port::bit_floor(std::max<std::size_t>(fft_cache_bytes / sizeof(T), 64));
+}
+
+// Number of columns processed together, which keeps them in cache, while each row segment is still long enough to
+// make good use of cache lines and vectorization.
+template <typename T>
+constexpr std::size_t fft_column_batch(std::size_t rows) {
+  return std::min(fft_row_length<T>(), port::bit_floor(std::max<std::size_t>(fft_cache_bytes / sizeof(T) / rows, 16)));
+}
+
+// Stages of the given half-lengths, which are powers of two in [low,high], on offsets [col,col+cols) modulo `row`
+// within each block, where `cols` divides `row`, and `row` either divides `low` or is no less than `high`. Those
+// stages are done with radix-4 butterflies, plus one radix-2 stage if their number is odd. Forward transform does the
+// radix-2 stage first, and inverse transform does it last.
+template <typename Kernel, typename It, typename W>
+void fft_dif_stages(It first, std::size_t n, std::size_t low, std::size_t high, std::size_t row, std::size_t col,
+                    std::size_t cols, const W* w, const W* w3) {
+  std::size_t len = high;
+  if (port::countr_zero(high / low) % 2 == 0) {
+    for (std::size_t block = 0; block < n; block += len * 2) {
+      for (std::size_t i = block + col; i < block + len; i += row) {
+        Kernel::forward(first + i, first + i + len, w + len + (i - block), std::min(cols, len));
+      }
+    }
+    len /= 2;
+  }
+  for (len /= 2; len >= low; len /= 4) {
+    for (std::size_t block = 0; block < n; block += len * 4) {
+      for (std::size_t i = block + col; i < block + len; i += row) {
+        std::size_t offset = i - block;
+        Kernel::forward4(first + i, len, w + len * 2 + offset, w + len + offset, w3 + len + offset, w[3],
+                         std::min(cols, len));
+      }
+    }
+  }
+}
+
+template <typename Kernel, typename It, typename W>
+void fft_dit_stages(It first, std::size_t n, std::size_t low, std::size_t high, std::size_t row, std::size_t col,
+                    std::size_t cols, const W* w, const W* w3) {
+  std::size_t len = low;
+  for (; len * 2 <= high; len *= 4) {
+    for (std::size_t block = 0; block < n; block += len * 4) {
+      for (std::size_t i = block + col; i < block + len; i += row) {
+        std::size_t offset = i - block;
+        Kernel::inverse4(first + i, len, w + len * 2 + offset, w + len + offset, w3 + len + offset, w[3],
+                         std::min(cols, len));
+      }
+    }
+  }
+  if (len == high) {
+    for (std::size_t block = 0; block < n; block += len * 2) {
+      for (std::size_t i = block + col; i < block + len; i += row) {
+        Kernel::inverse(first + i, first + i + len, w + len + (i - block), std::min(cols, len));
+      }
+    }
+  }
+}
+
+// Transform of length n fitting in cache, where the last stages may be fused by the kernel.
+template <typename Kernel, typename It, typename W>
+void fft_dif_in_cache(It first, std::size_t n, const W* w, const W* w3) {
+  const std::size_t fused = std::size_t(1) << Kernel::fused_stages;
+  if (n > fused) {
+    fft_dif_stages<Kernel>(first, n, fused, n / 2, n, 0, n, w, w3);
+  }
+  Kernel::forward_fused(first, n, w);
+}
+
+template <typename Kernel, typename It, typename W>
+void fft_dit_in_cache(It first, std::size_t n, const W* w, const W* w3) {
+  const std::size_t fused = std::size_t(1) << Kernel::fused_stages;
+  Kernel::inverse_fused(first, n, w);
+  if (n > fused) {
+    fft_dit_stages<Kernel>(first, n, fused, n / 2, n, 0, n, w, w3);
+  }
+}
+
+// Whether work on n elements of T is worth splitting into threads. Anything fitting in cache is not.
+template <typename T>
+constexpr bool fft_worth_parallel(std::size_t n, unsigned num_threads) {
+  return num_threads > 1 && n > fft_row_length<T>();
+}
+
+// Out-of-cache transforms are parallelized over batches of columns and then over rows, which are independent.
+template <typename Kernel, typename It, typename T>
+void fft_dif(It first, std::size_t n, const FftTwiddleTable<T>& table, unsigned num_threads) {
+  const auto* w = Kernel::twiddles(table);
+  const auto* w3 = Kernel::twiddles3(table);
+  const std::size_t row = fft_row_length<T>();
+  if (n <= row) {
+    fft_dif_in_cache<Kernel>(first, n, w, w3);
+    return;
+  }
+  const std::size_t cols = fft_column_batch<T>(n / row);
+  parallel_for(0, row / cols, num_threads,
+               [&](std::size_t k) { fft_dif_stages<Kernel>(first, n, row, n / 2, row, k * cols, cols, w, w3); });
+  parallel_for(0, n / row, num_threads, [&](std::size_t k) { fft_dif_in_cache<Kernel>(first + k * row, row, w, w3); });
+}
+
+template <typename Kernel, typename It, typename T>
+void fft_dit(It first, std::size_t n, const FftTwiddleTable<T>& table, unsigned num_threads) {
+  const auto* w = Kernel::twiddles(table);
+  const auto* w3 = Kernel::twiddles3(table);
+  const std::size_t row = fft_row_length<T>();
+  if (n <= row) {
+    fft_dit_in_cache<Kernel>(first, n, w, w3);
+    return;
+  }
+  parallel_for(0, n / row, num_threads, [&](std::size_t k) { fft_dit_in_cache<Kernel>(first + k * row, row, w, w3); });
+  const std::size_t cols = fft_column_batch<T>(n / row);
+  parallel_for(0, row / cols, num_threads,
+               [&](std::size_t k) { fft_dit_stages<Kernel>(first, n, row, n / 2, row, k * cols, cols, w, w3); });
+}
+
+// Calls f with the fastest kernel for the given range, and the range as an iterator accepted by that kernel.
+template <typename RandomIt, typename Func>
+void visit_fft_kernel(RandomIt first, std::size_t n, Func&& f) {
+  using T = typename std::iterator_traits<RandomIt>::value_type;
+  using Kernel = typename fft_kernel<T>::type;
+  using GenericKernel = typename fft_generic_kernel<T>::type;
+  if constexpr (is_contiguous_iterator_v<RandomIt> && !std::is_same_v<Kernel, GenericKernel>) {
+    if (n >> Kernel::fused_stages > 0) {
+      f(Kernel(), &*first);
+      return;
+    }
+  }
+  f(GenericKernel(), first);
+}
+
+}  // namespace impl
+
 /**
  * \brief In-place fast Fourier transform (FFT).
  * \ingroup conv
@@ -102,32 +838,34 @@ struct radix2_fft_root<std::complex<Float>> {
  * Let the input length be \f$2^L\f$, and `T` be `std::iterator_traits<RandomIt>::value_type`, then a specialization of
  * radix2_fft_root must exist for `T` and must provide \f$2^n\f$-th root of unity for all \f$0\leq n \leq L\f$.
  *
+ * Twiddling factors are computed once per `T` and cached for the rest of the program, so that repeated transforms of
+ * the same or smaller lengths, including those done by convolve() and multiply_multivar_fps(), have no setup cost.
+ *
+ * Pairs of radix-2 stages are merged into radix-4 stages, so that the whole array is swept only about
+ * \f$L/2\f$ times. Transforms larger than the cache are further blocked in the four-step manner, transforming
+ * columns then rows of cache-sized blocks, so that the whole array is swept only twice. The output order is always
+ * the same as that of plain radix-2 FFT.
+ *
+ * When `T` is MontgomeryModInt with modulus \f$N<R/4\f$, butterflies reduce values lazily as in Harvey's NTT, which
+ * lets intermediate values float in \f$[0,4N)\f$ and saves about half of the conditional reductions.
+ *
+ * When `T` is ::MMInt with modulus less than \f$2^{30}\f$ and the range is contiguous in memory, butterflies are
+ * vectorized with AVX2, unless disabled by `#define _CPLIB_NO_FORCE_AVX2_` without enabling AVX2 by command line.
+ *
+ * Transforms larger than the cache can be split into `num_threads` threads, while smaller ones are always done in the
+ * calling thread.
+ *
  * \tparam RandomIt Random-access iterator type.
  */
 template <typename RandomIt>
-void fft_inplace(RandomIt first, RandomIt last) {
-  using usize = std::size_t;
-  const usize n = std::distance(first, last);
+void fft_inplace(RandomIt first, RandomIt last, unsigned num_threads = 1) {
+  const std::size_t n = std::distance(first, last);
   assert(port::has_single_bit(n));
-  int log2n = port::countr_zero(n);
   using T = typename std::iterator_traits<RandomIt>::value_type;
-  std::vector<T> roots(log2n + 1);
-  for (int i = 0; i <= log2n; i++) {
-    roots[i] = radix2_fft_root<T>::get(i);
-  }
-  for (int stage = log2n - 1; stage >= 0; stage--) {
-    usize len = usize(1) << stage;
-    std::vector<T> w = impl::twiddling_factors(roots);
-    for (usize block = 0; block < n; block += len * 2) {
-      for (usize offset = 0; offset < len; offset++) {
-        usize i = block + offset, j = i + len;
-        T tmp = (first[i] - first[j]) * w[offset];
-        first[i] += first[j];
-        first[j] = tmp;
-      }
-    }
-    roots.pop_back();
-  }
+  const auto& twiddles = impl::FftTwiddleCache<T>::forward(port::countr_zero(n));
+  impl::visit_fft_kernel(first, n, [&](auto kernel, auto it) {
+    impl::fft_dif<decltype(kernel)>(it, n, twiddles, num_threads);
+  });
 }
 
 /**
@@ -140,36 +878,26 @@ void fft_inplace(RandomIt first, RandomIt last) {
  * radix2_fft_root must exist for `T` and must provide \f$2^n\f$-th root of unity for all \f$0\leq n \leq L\f$.
  * In addition, the multiplicative inverse of \f$2\f$ must exist in `T`.
  *
+ * See fft_inplace() for multithreading.
+ *
  * \tparam RandomIt Random-access iterator type.
  */
 template <typename RandomIt>
-void ifft_inplace(RandomIt first, RandomIt last) {
-  using usize = std::size_t;
-  const usize n = std::distance(first, last);
+void ifft_inplace(RandomIt first, RandomIt last, unsigned num_threads = 1) {
+  const std::size_t n = std::distance(first, last);
   assert(port::has_single_bit(n));
   int log2n = port::countr_zero(n);
   using T = typename std::iterator_traits<RandomIt>::value_type;
   T one = radix2_fft_root<T>::get(0);
-  std::vector<T> roots{one};
-  for (int stage = 0; stage < log2n; stage++) {
-    usize len = usize(1) << stage;
-    roots.push_back(one / radix2_fft_root<T>::get(stage + 1));
-    std::vector<T> w = impl::twiddling_factors(roots);
-    for (usize block = 0; block < n; block += len * 2) {
-      for (usize offset = 0; offset < len; offset++) {
-        usize i = block + offset, j = i + len;
-        first[j] *= w[offset];
-        T tmp = first[i] - first[j];
-        first[i] += first[j];
-        first[j] = tmp;
-      }
-    }
-  }
   T half = one / (one + one);
   T n_inv = pow(half, log2n);
-  for (usize i = 0; i < n; i++) {
-    first[i] *= n_inv;
-  }
+  const auto& twiddles = impl::FftTwiddleCache<T>::inverse(log2n);
+  impl::visit_fft_kernel(first, n, [&](auto kernel, auto it) {
+    using Kernel = decltype(kernel);
+    impl::fft_dit<Kernel>(it, n, twiddles, num_threads);
+    const std::size_t chunk = std::min(n, impl::fft_row_length<T>());
+    impl::parallel_for(0, n / chunk, num_threads, [&](std::size_t k) { Kernel::scale(it + k * chunk, chunk, n_inv); });
+  });
 }
 
 /**
@@ -180,10 +908,12 @@ void ifft_inplace(RandomIt first, RandomIt last) {
  *
  * Let the input length be \f$2^L\f$, then a specialization of radix2_fft_root must exist for `T` and must provide
  * \f$2^n\f$-th root of unity for all \f$0\leq n \leq L\f$.
+ *
+ * See fft_inplace(RandomIt, RandomIt, unsigned) for multithreading.
  */
 template <typename T>
-void fft_inplace(std::vector<T>& a) {
-  fft_inplace(a.begin(), a.end());
+void fft_inplace(std::vector<T>& a, unsigned num_threads = 1) {
+  fft_inplace(a.begin(), a.end(), num_threads);
 }
 
 /**
@@ -195,10 +925,14 @@ void fft_inplace(std::vector<T>& a) {
  * Let the input length be \f$2^L\f$, then a specialization of radix2_fft_root must exist for `T` and must provide
  * \f$2^n\f$-th root of unity for all \f$0\leq n \leq L\f$. In addition, the multiplicative inverse of \f$2\f$
  * must exist in `T`.
+ *
+ * See fft_inplace(RandomIt, RandomIt, unsigned) for multithreading.
  */
 template <typename T>
-void ifft_inplace(std::vector<T>& a) {
-  ifft_inplace(a.begin(), a.end());
+void ifft_inplace(std::vector<T>& a, unsigned num_threads = 1) {
+  ifft_inplace(a.begin(), a.end(), num_threads);
 }
 
-}  // namespace cplib
\ No newline at end of file
+}  // namespace cplib
+
+#pragma GCC pop_options
\ No newline at end of file
@@ -0,0 +1,504 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "cplib/conv/conv.hpp"
+#include "cplib/conv/fft.hpp"
+#include "cplib/num/pow.hpp"
+#include "cplib/num/sqrt.hpp"
+#include "cplib/port/bit.hpp"
+
+namespace cplib {
+
+namespace impl {
+
+// Inverse of a modulo x^n by g_i=-a_0^{-1}\sum_{j=1}^i a_jg_{i-j}, where a_0 is invertible.
+template <typename T>
+std::vector<T> fps_inv_naive(const std::vector<T>& a, std::size_t n) {
+  const T a0_inv = T(1) / a[0];
+  std::vector<T> g(n, T(0));
+  g[0] = a0_inv;
+  for (std::size_t i = 1; i < n; i++) {
+    T sum(0);
+    for (std::size_t j = 1; j <= std::min(i, a.size() - 1); j++) {
+      sum += a[j] * g[i - j];
+    }
+    g[i] = -sum * a0_inv;
+  }
+  return g;
+}
+
+// Extends g, the inverse of a modulo x^m, to that modulo x^{2m} by g'=g-g(ag-1), given g_fft, the transform of g at
+// length L=bit_ceil(2m), and h, that of a modulo x^{2m}, which is overwritten.
+//
+// Both products are cyclic convolutions of length L, whose coefficients wrapped around land on the first m, which are
+// not needed: ag-1 is known to be x^m e with e of length m, and only [m,2m) of ge is needed. The transform of g is
+// shared, so each step takes 5 transforms of length L, i.e. 5/3 multiplications of length m.
+template <typename T>
+void fps_inv_newton_step_transformed(std::vector<T>& h, std::vector<T>& g, const std::vector<T>& g_fft,
+                                     unsigned num_threads) {
+  using usize = std::size_t;
+  const usize m = g.size();
+  conv_transformed_inplace(h, g_fft, num_threads);
+  std::fill(h.begin(), h.begin() + m, T(0));
+  std::fill(h.begin() + m * 2, h.end(), T(0));
+  fft_inplace(h, num_threads);
+  conv_transformed_inplace(h, g_fft, num_threads);
+  g.resize(m * 2);
+  for (usize i = m; i < m * 2; i++) {
+    g[i] = -h[i];
+  }
+}
+
+template <typename T>
+void fps_inv_newton_step(const std::vector<T>& a, std::vector<T>& g, const std::vector<T>& g_fft,
+                         unsigned num_threads) {
+  std::vector<T> h(g_fft.size(), T(0));
+  std::copy(a.begin(), a.begin() + std::min(a.size(), g.size() * 2), h.begin());
+  fft_inplace(h, num_threads);
+  fps_inv_newton_step_transformed(h, g, g_fft, num_threads);
+}
+
+template <typename T>
+void fps_inv_newton_step(const std::vector<T>& a, std::vector<T>& g, unsigned num_threads) {
+  std::vector<T> g_fft = g;
+  g_fft.resize(port::bit_ceil(g.size() * 2), T(0));
+  fft_inplace(g_fft, num_threads);
+  fps_inv_newton_step(a, g, g_fft, num_threads);
+}
+
+// Returns 1/i for 1<=i<n by 1/i=-floor(p/i)/(p mod i), or 0 for multiples of p.
+template <typename T>
+std::vector<T> fps_inverses(std::size_t n) {
+  const auto p = T::mod();
+  std::vector<T> ret(std::max<std::size_t>(n, 2), T(0));
+  ret[1] = T(1);
+  for (std::size_t i = 2; i < n && i < p; i++) {
+    ret[i] = -T(p / i) * ret[p % i];
+  }
+  return ret;
+}
+
+template <typename T>
+std::vector<T> fps_derivative(const std::vector<T>& a, std::size_t n) {
+  std::vector<T> ret;
+  for (std::size_t i = 1; i < std::min(a.size(), n); i++) {
+    ret.push_back(a[i] * T(i));
+  }
+  return ret;
+}
+
+// Newton's iteration for exp and sqrt starts from this many coefficients computed naively, a power of two so that
+// transforms of the first half of each result can be taken from those of the whole.
+template <typename T>
+std::size_t fps_newton_base() {
+  return port::bit_floor(conv_thresholds<T>().naive);
+}
+
+// exp(a) modulo x^n by if_i=\sum_{j=1}^i ja_jf_{i-j}, which is f'=a'f.
+template <typename T>
+std::vector<T> fps_exp_naive(const std::vector<T>& a, std::size_t n, const std::vector<T>& inv) {
+  std::vector<T> f(n, T(0));
+  f[0] = T(1);
+  for (std::size_t i = 1; i < n; i++) {
+    T sum(0);
+    for (std::size_t j = 1; j <= i && j < a.size(); j++) {
+      sum += a[j] * T(j) * f[i - j];
+    }
+    f[i] = sum * inv[i];
+  }
+  return f;
+}
+
+// Extends f=exp(a) modulo x^m to modulo x^{2m} by f'=f(1+a-log f), where m is a power of two, given g, the inverse of
+// f modulo x^{m/2}, and g_fft, its transform of length m. g and g_fft are extended to modulo x^m and length 2m.
+//
+// With q=(a mod x^m)', r=qf-f' is known to be x^{m-1}e with e of length m, and modulo x^{2m-1},
+// (log f)'=f'/f=q-r/f=q-rg. Since q has degree below m-1, log f=-\int rg on [m,2m), so f'=f+fx with x=a+\int rg
+// restricted to [m,2m). g itself is extended by fps_inv_newton_step(). All products are cyclic convolutions of length m
+// or 2m, where the coefficients wrapped around are not needed, and the transform of length m of f is the first half of
+// that of length 2m in bit-reversed order. Each step takes 6 transforms of length 2m and 5 of length m, about 17/6
+// multiplications of length m.
+template <typename T>
+void fps_exp_newton_step(const std::vector<T>& a, std::vector<T>& f, std::vector<T>& g, std::vector<T>& g_fft,
+                         const std::vector<T>& inv, unsigned num_threads) {
+  using usize = std::size_t;
+  const usize m = f.size(), len = m * 2;
+  std::vector<T> f_fft = f;
+  f_fft.resize(len, T(0));
+  fft_inplace(f_fft, num_threads);
+  const std::vector<T> f_fft_half(f_fft.begin(), f_fft.begin() + m);
+  std::vector<T> h = f_fft_half;
+  fps_inv_newton_step_transformed(h, g, g_fft, num_threads);
+  g_fft = g;
+  g_fft.resize(len, T(0));
+  fft_inplace(g_fft, num_threads);
+  // qf modulo x^m-1 minus f' leaves coefficients [m,2m-1) of r at [0,m-1), and coefficient m-1 in place.
+  std::vector<T> r(m, T(0));
+  for (usize i = 1; i < std::min(a.size(), m); i++) {
+    r[i - 1] = a[i] * T(i);
+  }
+  fft_inplace(r, num_threads);
+  conv_transformed_inplace(r, f_fft_half, num_threads);
+  std::vector<T> x(len, T(0));
+  x[m - 1] = r[m - 1];
+  for (usize i = 0; i + 1 < m; i++) {
+    x[m + i] = r[i] - f[i + 1] * T(i + 1);
+  }
+  fft_inplace(x, num_threads);
+  conv_transformed_inplace(x, g_fft, num_threads);
+  for (usize i = len; i-- > m;) {
+    x[i] = x[i - 1] * inv[i] + (i < a.size() ? a[i] : T(0));
+  }
+  std::fill(x.begin(), x.begin() + m, T(0));
+  fft_inplace(x, num_threads);
+  conv_transformed_inplace(x, f_fft, num_threads);
+  f.resize(len);
+  std::copy(x.begin() + m, x.end(), f.begin() + m);
+}
+
+// sqrt(b) modulo x^n where b_0=1, by 2s_i=b_i-\sum_{j=1}^{i-1} s_js_{i-j}.
+template <typename T>
+std::vector<T> fps_sqrt_naive(const std::vector<T>& b, std::size_t n) {
+  const T inv2 = T(1) / T(2);
+  std::vector<T> s(n, T(0));
+  s[0] = T(1);
+  for (std::size_t i = 1; i < n; i++) {
+    T sum = i < b.size() ? b[i] : T(0);
+    for (std::size_t j = 1; j < i; j++) {
+      sum -= s[j] * s[i - j];
+    }
+    s[i] = sum * inv2;
+  }
+  return s;
+}
+
+// Extends s=sqrt(b) modulo x^m to modulo x^{2m} by s'=s+(b-s^2)/2s, given h, the inverse of s modulo x^m, and h_fft,
+// its transform of length 2m. Since b-s^2 is a multiple of x^m, h modulo x^m suffices. Unless `last`, h and h_fft are
+// then extended to modulo x^{2m} and length 4m for the next step.
+template <typename T>
+void fps_sqrt_newton_step(const std::vector<T>& b, std::vector<T>& s, std::vector<T>& h, std::vector<T>& h_fft,
+                          bool last, unsigned num_threads) {
+  using usize = std::size_t;
+  const usize m = s.size(), len = m * 2;
+  std::vector<T> e = s;
+  e.resize(len, T(0));
+  fft_inplace(e, num_threads);
+  conv_transformed_inplace(e, e, num_threads);
+  std::fill(e.begin(), e.begin() + m, T(0));
+  for (usize i = m; i < len; i++) {
+    e[i] = (i < b.size() ? b[i] : T(0)) - e[i];
+  }
+  fft_inplace(e, num_threads);
+  conv_transformed_inplace(e, h_fft, num_threads);
+  const T inv2 = T(1) / T(2);
+  s.resize(len);
+  for (usize i = m; i < len; i++) {
+    s[i] = e[i] * inv2;
+  }
+  if (!last) {
+    fps_inv_newton_step(s, h, h_fft, num_threads);
+    h_fft = h;
+    h_fft.resize(len * 2, T(0));
+    fft_inplace(h_fft, num_threads);
+  }
+}
+
+// Schoolbook division, where a is no shorter than b.
+template <typename T>
+std::pair<std::vector<T>, std::vector<T>> poly_divmod_naive(const std::vector<T>& a, const std::vector<T>& b) {
+  const std::size_t k = a.size() - b.size() + 1, m = b.size();
+  const T lead_inv = T(1) / b.back();
+  std::vector<T> q(k), r = a;
+  for (std::size_t i = k; i-- > 0;) {
+    q[i] = r[i + m - 1] * lead_inv;
+    for (std::size_t j = 0; j < m; j++) {
+      r[i + j] -= q[i] * b[j];
+    }
+  }
+  r.resize(m - 1);
+  return {q, r};
+}
+
+}  // namespace impl
+
+/**
+ * \brief Returns the inverse of a formal power series modulo \f$x^n\f$.
+ * \ingroup conv
+ *
+ * Returns \f$g\f$ of length `n` such that \f$ag\equiv 1\pmod{x^n}\f$, where `a[0]` must be invertible.
+ *
+ * It is computed with Newton's iteration \f$g\gets g-g(ag-1)\f$, which doubles the number of correct coefficients in
+ * each step. Each step takes 5 transforms of twice the current length, as the transform of \f$g\f$ is shared by both
+ * products and neither needs the full product length (see middle_product()), so the whole inverse costs about
+ * \f$5/3\f$ times a convolution of two arrays of length \f$n\f$. The first coefficients are computed naively, in
+ * \f$O(n^2)\f$ time for short inputs.
+ *
+ * Each transform can be split into `num_threads` threads, see fft_inplace().
+ *
+ * \tparam T See fft_inplace() for requirements for `T`, which must also support division.
+ */
+template <typename T>
+std::vector<T> fps_inv(const std::vector<T>& a, std::size_t n, unsigned num_threads = 1) {
+  assert(!a.empty());
+  if (n == 0) {
+    return {};
+  }
+  // Start from ceil(n/2^k) coefficients, so that doubling never overshoots n by more than 2^k.
+  std::size_t m = n;
+  int steps = 0;
+  while (!impl::conv_naive_is_efficient<T>(m, m)) {
+    m = (m + 1) / 2;
+    steps++;
+  }
+  std::vector<T> g = impl::fps_inv_naive(a, m);
+  for (int s = 0; s < steps; s++) {
+    impl::fps_inv_newton_step(a, g, num_threads);
+  }
+  g.resize(n);
+  return g;
+}
+
+/**
+ * \brief Returns the quotient of two formal power series modulo \f$x^n\f$.
+ * \ingroup conv
+ *
+ * Returns \f$q\f$ of length `n` such that \f$bq\equiv a\pmod{x^n}\f$, where `b[0]` must be invertible. It is
+ * computed as `a` times fps_inv() of `b`.
+ *
+ * \tparam T See fft_inplace() for requirements for `T`, which must also support division.
+ */
+template <typename T>
+std::vector<T> fps_div(const std::vector<T>& a, const std::vector<T>& b, std::size_t n, unsigned num_threads = 1) {
+  return convolve_truncated(a, fps_inv(b, n, num_threads), n, num_threads);
+}
+
+/**
+ * \brief Returns the quotient of polynomial division.
+ * \ingroup conv
+ *
+ * Returns \f$q\f$ such that \f$\deg(a-bq)<\deg b\f$, where polynomials are given by coefficients in increasing order
+ * of degree. The leading coefficient of `b`, i.e. its last element, must be invertible. `q` has length
+ * `a.size() - b.size() + 1`, or is empty if `a` is shorter than `b`.
+ *
+ * The reversed quotient is the reversed `a` divided by the reversed `b` as formal power series modulo
+ * \f$x^{\deg q+1}\f$, see fps_div(). Short inputs are divided naively.
+ *
+ * \tparam T See fft_inplace() for requirements for `T`, which must also support division.
+ */
+template <typename T>
+std::vector<T> poly_div(const std::vector<T>& a, const std::vector<T>& b, unsigned num_threads = 1) {
+  assert(!b.empty());
+  if (a.size() < b.size()) {
+    return {};
+  }
+  const std::size_t k = a.size() - b.size() + 1;
+  if (impl::conv_naive_is_efficient<T>(k, b.size())) {
+    return impl::poly_divmod_naive(a, b).first;
+  }
+  std::vector<T> a_rev(a.rbegin(), a.rbegin() + k), b_rev(b.rbegin(), b.rbegin() + std::min(b.size(), k));
+  std::vector<T> q = fps_div(a_rev, b_rev, k, num_threads);
+  std::reverse(q.begin(), q.end());
+  return q;
+}
+
+/**
+ * \brief Returns the quotient and remainder of polynomial division.
+ * \ingroup conv
+ *
+ * Returns \f$(q,r)\f$ such that \f$a=bq+r\f$ and \f$\deg r<\deg b\f$. `q` is the same as poly_div(), and `r` always
+ * has length `b.size() - 1`, with leading zeros kept. Only the low `b.size() - 1` coefficients of \f$bq\f$ are
+ * needed for the remainder, see convolve_truncated().
+ *
+ * \tparam T See fft_inplace() for requirements for `T`, which must also support division.
+ */
+template <typename T>
+std::pair<std::vector<T>, std::vector<T>> poly_divmod(const std::vector<T>& a, const std::vector<T>& b,
+                                                      unsigned num_threads = 1) {
+  assert(!b.empty());
+  const std::size_t n = a.size(), m = b.size();
+  if (n < m) {
+    std::vector<T> r = a;
+    r.resize(m - 1, T(0));
+    return {{}, r};
+  }
+  if (impl::conv_naive_is_efficient<T>(n - m + 1, m)) {
+    return impl::poly_divmod_naive(a, b);
+  }
+  std::vector<T> q = poly_div(a, b, num_threads);
+  std::vector<T> r = convolve_truncated(b, q, m - 1, num_threads);
+  for (std::size_t i = 0; i < m - 1; i++) {
+    r[i] = a[i] - r[i];
+  }
+  return {q, r};
+}
+
+/**
+ * \brief Returns the remainder of polynomial division.
+ * \ingroup conv
+ * \see poly_divmod()
+ */
+template <typename T>
+std::vector<T> poly_mod(const std::vector<T>& a, const std::vector<T>& b, unsigned num_threads = 1) {
+  return poly_divmod(a, b, num_threads).second;
+}
+
+/**
+ * \brief Returns the logarithm of a formal power series modulo \f$x^n\f$.
+ * \ingroup conv
+ *
+ * Returns \f$\log a=\int a'/a\f$ modulo \f$x^n\f$, where `a[0]` must be 1. It takes one fps_div(), about
+ * \f$8/3\f$ times a convolution of two arrays of length \f$n\f$.
+ *
+ * \tparam T A modular integer type with prime modulus greater than `n`, see fft_inplace() for other requirements.
+ */
+template <typename T>
+std::vector<T> fps_log(const std::vector<T>& a, std::size_t n, unsigned num_threads = 1) {
+  assert(!a.empty() && a[0] == T(1));
+  if (n == 0) {
+    return {};
+  }
+  const std::vector<T> q = fps_div(impl::fps_derivative(a, n), a, n - 1, num_threads);
+  const std::vector<T> inv = impl::fps_inverses<T>(n);
+  std::vector<T> ret(n, T(0));
+  for (std::size_t i = 1; i < n; i++) {
+    ret[i] = q[i - 1] * inv[i];
+  }
+  return ret;
+}
+
+/**
+ * \brief Returns the exponential of a formal power series modulo \f$x^n\f$.
+ * \ingroup conv
+ *
+ * Returns \f$\exp a\f$ modulo \f$x^n\f$, where `a[0]` must be 0.
+ *
+ * It is computed with Newton's iteration \f$f\gets f(1+a-\log f)\f$, where the inverse of \f$f\f$ needed by the
+ * logarithm is extended along with \f$f\f$ by one step of fps_inv() each time instead of computed from scratch, and
+ * transforms are shared between the products of each step. The whole exponential costs about \f$17/6\f$ times a
+ * convolution of two arrays of length \f$n\f$ (rounded up to a power of two). Short inputs are done naively in
+ * \f$O(n^2)\f$ time.
+ *
+ * Each transform can be split into `num_threads` threads, see fft_inplace().
+ *
+ * \tparam T A modular integer type with prime modulus greater than `n`, see fft_inplace() for other requirements.
+ */
+template <typename T>
+std::vector<T> fps_exp(const std::vector<T>& a, std::size_t n, unsigned num_threads = 1) {
+  assert(a.empty() || a[0] == T(0));
+  if (n == 0) {
+    return {};
+  }
+  const std::vector<T> inv = impl::fps_inverses<T>(port::bit_ceil(n));
+  std::size_t m = std::min(n, impl::fps_newton_base<T>());
+  std::vector<T> f = impl::fps_exp_naive(a, m, inv);
+  if (m < n) {
+    std::vector<T> g = impl::fps_inv_naive(f, m / 2), g_fft = g;
+    g_fft.resize(m, T(0));
+    fft_inplace(g_fft, num_threads);
+    for (; m < n; m *= 2) {
+      impl::fps_exp_newton_step(a, f, g, g_fft, inv, num_threads);
+    }
+  }
+  f.resize(n);
+  return f;
+}
+
+/**
+ * \brief Returns a power of a formal power series modulo \f$x^n\f$.
+ * \ingroup conv
+ *
+ * Returns \f$a^k\f$ modulo \f$x^n\f$, where \f$0^0=1\f$. With \f$a=cx^d(1+\dots)\f$, it is computed as
+ * \f$c^kx^{dk}\exp(k\log(a/cx^d))\f$, which takes fps_log() and fps_exp() of length \f$n-dk\f$.
+ *
+ * \tparam T A modular integer type with prime modulus greater than `n`, see fft_inplace() for other requirements.
+ */
+template <typename T>
+std::vector<T> fps_pow(const std::vector<T>& a, uint64_t k, std::size_t n, unsigned num_threads = 1) {
+  using usize = std::size_t;
+  std::vector<T> ret(n, T(0));
+  if (n == 0) {
+    return ret;
+  }
+  if (k == 0) {
+    ret[0] = T(1);
+    return ret;
+  }
+  const usize d = std::find_if(a.begin(), a.end(), [](const T& x) { return x != T(0); }) - a.begin();
+  if (d == a.size() || (d > 0 && k >= (n + d - 1) / d)) {
+    return ret;
+  }
+  const usize shift = d * k, len = n - shift;
+  const T c = a[d], c_inv = T(1) / c;
+  std::vector<T> b;
+  for (usize i = d; i < a.size() && i - d < len; i++) {
+    b.push_back(a[i] * c_inv);
+  }
+  std::vector<T> log_b = fps_log(b, len, num_threads);
+  const T k_mod(k);
+  for (T& x : log_b) {
+    x *= k_mod;
+  }
+  const std::vector<T> pow_b = fps_exp(log_b, len, num_threads);
+  const T c_pow = pow(c, k);
+  for (usize i = 0; i < len; i++) {
+    ret[shift + i] = pow_b[i] * c_pow;
+  }
+  return ret;
+}
+
+/**
+ * \brief Returns a square root of a formal power series modulo \f$x^n\f$.
+ * \ingroup conv
+ *
+ * Returns \f$s\f$ of length `n` such that \f$s^2\equiv a\pmod{x^n}\f$, or `std::nullopt` if there is none. With
+ * \f$a=cx^d(1+\dots)\f$, a root exists if \f$d\geq n\f$, in which case 0 is returned, or if \f$d\f$ is even and
+ * \f$c\f$ is a quadratic residue. The constant term of \f$s/x^{d/2}\f$ is the root of \f$c\f$ from sqrt_mod_fp(),
+ * and negating \f$s\f$ gives the other root.
+ *
+ * It is computed with Newton's iteration \f$s\gets s+(a-s^2)/2s\f$, where the inverse of \f$s\f$ is extended along
+ * with \f$s\f$ by one step of fps_inv() each time, which costs about \f$10/3\f$ times a convolution of two arrays of
+ * length \f$n\f$ (rounded up to a power of two), compared to about 5.5 with fps_pow() of exponent \f$1/2\f$.
+ *
+ * \tparam T A modular integer type with odd prime modulus, see fft_inplace() for other requirements.
+ */
+template <typename T>
+std::optional<std::vector<T>> fps_sqrt(const std::vector<T>& a, std::size_t n, unsigned num_threads = 1) {
+  using usize = std::size_t;
+  const usize d = std::find_if(a.begin(), a.end(), [](const T& x) { return x != T(0); }) - a.begin();
+  std::vector<T> ret(n, T(0));
+  if (d >= std::min(a.size(), n)) {
+    return ret;
+  }
+  std::optional<T> c = sqrt_mod_fp(a[d]);
+  if (d % 2 == 1 || !c) {
+    return std::nullopt;
+  }
+  const usize shift = d / 2, len = n - shift;
+  const T c_inv = T(1) / a[d];
+  std::vector<T> b;
+  for (usize i = d; i < a.size() && i - d < len; i++) {
+    b.push_back(a[i] * c_inv);
+  }
+  usize m = std::min(len, impl::fps_newton_base<T>());
+  std::vector<T> s = impl::fps_sqrt_naive(b, m);
+  if (m < len) {
+    std::vector<T> h = impl::fps_inv_naive(s, m), h_fft = h;
+    h_fft.resize(m * 2, T(0));
+    fft_inplace(h_fft, num_threads);
+    for (; m < len; m *= 2) {
+      impl::fps_sqrt_newton_step(b, s, h, h_fft, m * 2 >= len, num_threads);
+    }
+  }
+  for (usize i = 0; i < len; i++) {
+    ret[shift + i] = s[i] * *c;
+  }
+  return ret;
+}
+
+}  // namespace cplib
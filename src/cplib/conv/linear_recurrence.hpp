@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "cplib/conv/conv.hpp"
+#include "cplib/conv/fft.hpp"
+#include "cplib/port/bit.hpp"
+
+namespace cplib {
+
+namespace impl {
+
+// [x^k]p/q by Bostan-Mori on coefficients, for short p and q.
+template <typename T>
+T kth_coefficient_naive(std::vector<T> p, std::vector<T> q, uint64_t k) {
+  while (k > 0) {
+    std::vector<T> q_neg = q;
+    for (std::size_t i = 1; i < q_neg.size(); i += 2) {
+      q_neg[i] = -q_neg[i];
+    }
+    const std::vector<T> u = convolve(p, q_neg), v = convolve(q, q_neg);
+    p.clear();
+    q.clear();
+    for (std::size_t i = k % 2; i < u.size(); i += 2) {
+      p.push_back(u[i]);
+    }
+    for (std::size_t i = 0; i < v.size(); i += 2) {
+      q.push_back(v[i]);
+    }
+    if (p.empty()) {
+      return T(0);
+    }
+    k /= 2;
+  }
+  return p[0] / q[0];
+}
+
+}  // namespace impl
+
+/**
+ * \brief Berlekamp-Massey algorithm, which finds the shortest linear recurrence of a sequence.
+ * \ingroup conv
+ *
+ * Returns \f$q\f$ of the smallest length \f$d+1\f$ with \f$q_0=1\f$ such that \f$\sum_{j=0}^d q_js_{i-j}=0\f$ for all
+ * \f$d\leq i<n\f$, where \f$n\f$ is the length of `s`. That is, \f$s_i=-\sum_{j=1}^d q_js_{i-j}\f$, and
+ * \f$q\f$ is the denominator of the generating function of \f$s\f$ as a rational series. If \f$s\f$ satisfies a
+ * recurrence of order \f$d\f$ and \f$n\geq 2d\f$, the result is that recurrence.
+ *
+ * It takes \f$O(n^2)\f$ time.
+ *
+ * \tparam T A field, such as a modular integer type with prime modulus.
+ */
+template <typename T>
+std::vector<T> berlekamp_massey(const std::vector<T>& s) {
+  using usize = std::size_t;
+  // q is the current recurrence, and b is the one before the last change of its length, which happened `shift`
+  // elements ago with discrepancy b_disc.
+  std::vector<T> q{T(1)}, b{T(1)};
+  usize len = 0, shift = 1;
+  T b_disc(1);
+  for (usize n = 0; n < s.size(); n++, shift++) {
+    T disc(0);
+    for (usize j = 0; j <= len; j++) {
+      disc += q[j] * s[n - j];
+    }
+    if (disc == T(0)) {
+      continue;
+    }
+    const T coef = disc / b_disc;
+    std::vector<T> prev = q;
+    if (q.size() < b.size() + shift) {
+      q.resize(b.size() + shift, T(0));
+    }
+    for (usize j = 0; j < b.size(); j++) {
+      q[j + shift] -= coef * b[j];
+    }
+    if (len * 2 <= n) {
+      len = n + 1 - len;
+      q.resize(std::max(q.size(), len + 1), T(0));
+      b = std::move(prev);
+      b_disc = disc;
+      shift = 0;
+    }
+  }
+  q.resize(len + 1);
+  return q;
+}
+
+/**
+ * \brief Returns the `k`-th coefficient of the rational series \f$p/q\f$.
+ * \ingroup conv
+ *
+ * `q[0]` must be invertible. It takes \f$O(n\log n\log k)\f$ time, where \f$n\f$ is the longer length of `p` and
+ * `q`, by the algorithm of Bostan and Mori: \f$p(x)/q(x)=p(x)q(-x)/q(x)q(-x)\f$ where the denominator is even, so the
+ * \f$k\f$-th coefficient is that of \f$u_{k\bmod 2}(x)/v(x)\f$ at \f$\lfloor k/2\rfloor\f$, with \f$u_0,u_1\f$ and
+ * \f$v\f$ being the even and odd parts of the numerator and the denominator.
+ *
+ * Everything is done on transforms of length \f$L\geq 2n\f$: since \f$q(-x)\f$ at \f$\omega^j\f$ is \f$q\f$ at
+ * \f$-\omega^j\f$, the two are adjacent in bit-reversed order, and the even and odd parts at \f$\omega^{2j}\f$ come
+ * from the same pair. The resulting transforms of length \f$L/2\f$ are the first half of those of length \f$L\f$, and
+ * the other half is one inverse transform and one transform of length \f$L/2\f$ away. So each step takes 2 transforms
+ * of length \f$L\f$, fewer than one multiplication. Short inputs are done on coefficients.
+ *
+ * Each transform can be split into `num_threads` threads, see fft_inplace().
+ *
+ * \tparam T See fft_inplace() for requirements for `T`, which must also support division.
+ */
+template <typename T>
+T kth_coefficient(std::vector<T> p, std::vector<T> q, uint64_t k, unsigned num_threads = 1) {
+  using usize = std::size_t;
+  assert(!q.empty());
+  if (p.empty()) {
+    return T(0);
+  }
+  const usize n = std::max(p.size(), q.size());
+  if (impl::conv_naive_is_efficient<T>(n, n)) {
+    return impl::kth_coefficient_naive(p, q, k);
+  }
+  const usize len = port::bit_ceil(n * 2), half = len / 2;
+  // omega[t]=\omega_L^t in natural order, and odd[i]=\omega_L^{-rev(i)}/2 in bit-reversed order for the odd part,
+  // where rev(i)=rev(i-2^t)+half/2^{t+1} for 2^t<=i<2^{t+1}.
+  const auto& table = impl::FftTwiddleCache<T>::forward(port::countr_zero(len));
+  const std::vector<T> omega(table.w.begin() + half, table.w.begin() + len);
+  const T inv2 = T(1) / T(2);
+  std::vector<T> odd(half);
+  odd[0] = inv2;
+  for (int t = 0; (usize(1) << t) < half; t++) {
+    const T root = T(1) / radix2_fft_root<T>::get(t + 2);
+    for (usize i = usize(1) << t; i < (usize(2) << t); i++) {
+      odd[i] = odd[i - (usize(1) << t)] * root;
+    }
+  }
+  p.resize(len, T(0));
+  q.resize(len, T(0));
+  fft_inplace(p, num_threads);
+  fft_inplace(q, num_threads);
+  // Transforms of length L/2 of the first half into those of length L, by twisting coefficients with \omega_L^t.
+  auto extend = [&](std::vector<T>& x) {
+    std::copy(x.begin(), x.begin() + half, x.begin() + half);
+    ifft_inplace(x.begin() + half, x.end(), num_threads);
+    for (usize t = 0; t < half; t++) {
+      x[half + t] *= omega[t];
+    }
+    fft_inplace(x.begin() + half, x.end(), num_threads);
+  };
+  while (true) {
+    // Positions 2i and 2i+1 hold values at \omega^j and -\omega^j, and i is never after 2i.
+    for (usize i = 0; i < half; i++) {
+      const T p0 = p[i * 2], p1 = p[i * 2 + 1], q0 = q[i * 2], q1 = q[i * 2 + 1];
+      p[i] = k % 2 == 0 ? (p0 * q1 + p1 * q0) * inv2 : (p0 * q1 - p1 * q0) * odd[i];
+      q[i] = q0 * q1;
+    }
+    k /= 2;
+    if (k == 0) {
+      break;
+    }
+    extend(p);
+    extend(q);
+  }
+  // The sum of values at all roots of unity of order L/2 is L/2 times the constant term.
+  T p_sum(0), q_sum(0);
+  for (usize i = 0; i < half; i++) {
+    p_sum += p[i];
+    q_sum += q[i];
+  }
+  return p_sum / q_sum;
+}
+
+/**
+ * \brief Returns the `k`-th term of a linearly recurrent sequence.
+ * \ingroup conv
+ *
+ * The sequence satisfies \f$\sum_{j=0}^d q_ja_{i-j}=0\f$ for \f$i\geq d\f$, where `q` is of length \f$d+1\f$ with
+ * `q[0]` invertible (such as returned by berlekamp_massey()), and `a` holds at least the first \f$d\f$ terms. Its
+ * generating function is \f$p/q\f$ with \f$p=aq\bmod x^d\f$, see kth_coefficient().
+ *
+ * \tparam T See fft_inplace() for requirements for `T`, which must also support division.
+ */
+template <typename T>
+T linear_recurrence_kth_term(const std::vector<T>& a, const std::vector<T>& q, uint64_t k,
+                             unsigned num_threads = 1) {
+  assert(!q.empty());
+  const std::size_t d = q.size() - 1;
+  assert(a.size() >= d);
+  if (k < a.size()) {
+    return a[k];
+  }
+  return kth_coefficient(convolve_truncated(a, q, d, num_threads), q, k, num_threads);
+}
+
+}  // namespace cplib
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "cplib/conv/conv.hpp"
+#include "cplib/conv/fft.hpp"
+#include "cplib/conv/fps.hpp"
+#include "cplib/port/bit.hpp"
+#include "cplib/utils/parallel.hpp"
+
+namespace cplib {
+
+namespace impl {
+
+// Calls f(threads) and g(threads) with the threads split between them, concurrently if there are at least two.
+template <typename F, typename G>
+void subtree_invoke(unsigned num_threads, F&& f, G&& g) {
+  if (num_threads > 1) {
+    const unsigned g_threads = num_threads / 2;
+    parallel_invoke([&] { f(num_threads - g_threads); }, [&] { g(g_threads); });
+  } else {
+    f(1);
+    g(1);
+  }
+}
+
+// Subproduct tree of points x_i, where node v covers [l,r), split at the middle into children 2v and 2v+1, and holds
+// \prod_{l<=i<r}(x-x_i). The tree takes O(n\log n) memory.
+//
+// Evaluation goes down the tree with transposed multiplication (Bostan, Lecerf and Schost, Tellegen's principle and
+// the synthesis of algorithms, 2003): node v holds D_v[k]=\sum_j f_j[y^j]y^k/P_v(y) for k<r-l, where P_v(y) is the
+// reversal \prod(1-x_iy), so that D_v[0]=f(x_l) at leaves, and D_c[k]=\sum_t P_s[t]D_v[k+t] for a child c with
+// sibling s, which is a middle product with the sibling's polynomial. Unlike going down with remainders, no division
+// is needed below the root.
+template <typename T>
+class SubproductTree {
+ public:
+  SubproductTree(const std::vector<T>& xs, unsigned num_threads) : xs_(xs), prods_(xs.size() * 4) {
+    build(1, 0, xs.size(), num_threads);
+  }
+
+  // Returns \prod(x-x_i) over all points.
+  const std::vector<T>& root() const { return prods_[1]; }
+
+  // Returns f(x_i) for all points.
+  std::vector<T> evaluate(const std::vector<T>& f, unsigned num_threads) const {
+    const std::size_t n = f.size(), m = xs_.size();
+    std::vector<T> p_root(root().rbegin(), root().rend());
+    std::vector<T> r = fps_inv(p_root, n, num_threads);
+    std::reverse(r.begin(), r.end());
+    std::vector<T> f_pad = f, ret(m);
+    f_pad.resize(n + m - 1, T(0));
+    go_down(1, 0, m, middle_product(f_pad, r, num_threads), ret, num_threads);
+    return ret;
+  }
+
+  // Returns \sum_i c_i\prod_{j\neq i}(x-x_j).
+  std::vector<T> combine(const std::vector<T>& c, unsigned num_threads) const {
+    return go_up(1, 0, xs_.size(), c, num_threads);
+  }
+
+ private:
+  std::vector<T> xs_;
+  std::vector<std::vector<T>> prods_;
+
+  void build(std::size_t v, std::size_t l, std::size_t r, unsigned num_threads) {
+    if (r - l == 1) {
+      prods_[v] = {-xs_[l], T(1)};
+      return;
+    }
+    const std::size_t mid = (l + r) / 2;
+    subtree_invoke(
+        num_threads, [&](unsigned t) { build(v * 2, l, mid, t); }, [&](unsigned t) { build(v * 2 + 1, mid, r, t); });
+    prods_[v] = convolve(prods_[v * 2], prods_[v * 2 + 1], num_threads);
+  }
+
+  // Both middle products share the transform of d, of length bit_ceil(r-l), which wraps the full products around only
+  // onto coefficients not needed.
+  void go_down(std::size_t v, std::size_t l, std::size_t r, std::vector<T> d, std::vector<T>& out,
+               unsigned num_threads) const {
+    if (r - l == 1) {
+      out[l] = d[0];
+      return;
+    }
+    const std::size_t mid = (l + r) / 2;
+    const std::vector<T>& left = prods_[v * 2];
+    const std::vector<T>& right = prods_[v * 2 + 1];
+    std::vector<T> d_left, d_right;
+    if (conv_naive_is_efficient<T>(r - l, r - l)) {
+      d_left = middle_product(d, right);
+      d_right = middle_product(d, left);
+    } else {
+      const std::size_t len = port::bit_ceil(r - l);
+      d.resize(len, T(0));
+      fft_inplace(d, num_threads);
+      d_left = right;
+      d_left.resize(len, T(0));
+      fft_inplace(d_left, num_threads);
+      conv_transformed_inplace(d_left, d, num_threads);
+      d_left.erase(d_left.begin(), d_left.begin() + (r - mid));
+      d_left.resize(mid - l);
+      d_right = left;
+      d_right.resize(len, T(0));
+      fft_inplace(d_right, num_threads);
+      conv_transformed_inplace(d_right, d, num_threads);
+      d_right.erase(d_right.begin(), d_right.begin() + (mid - l));
+      d_right.resize(r - mid);
+    }
+    d = {};
+    subtree_invoke(
+        num_threads, [&](unsigned t) { go_down(v * 2, l, mid, std::move(d_left), out, t); },
+        [&](unsigned t) { go_down(v * 2 + 1, mid, r, std::move(d_right), out, t); });
+  }
+
+  // Returns N_v=N_{2v}P_{2v+1}+N_{2v+1}P_{2v}, with the sum taken on transforms.
+  std::vector<T> go_up(std::size_t v, std::size_t l, std::size_t r, const std::vector<T>& c,
+                       unsigned num_threads) const {
+    if (r - l == 1) {
+      return {c[l]};
+    }
+    const std::size_t mid = (l + r) / 2;
+    std::vector<T> n_left, n_right;
+    subtree_invoke(
+        num_threads, [&](unsigned t) { n_left = go_up(v * 2, l, mid, c, t); },
+        [&](unsigned t) { n_right = go_up(v * 2 + 1, mid, r, c, t); });
+    std::vector<T> left = prods_[v * 2], right = prods_[v * 2 + 1];
+    if (conv_naive_is_efficient<T>(r - l, r - l)) {
+      convolve_inplace(n_left, right);
+      convolve_inplace(n_right, left);
+      for (std::size_t i = 0; i < r - l; i++) {
+        n_left[i] += n_right[i];
+      }
+      return n_left;
+    }
+    const std::size_t len = port::bit_ceil(r - l);
+    for (std::vector<T>* x : {&n_left, &n_right, &left, &right}) {
+      x->resize(len, T(0));
+      fft_inplace(*x, num_threads);
+    }
+    for (std::size_t i = 0; i < len; i++) {
+      n_left[i] = n_left[i] * right[i] + n_right[i] * left[i];
+    }
+    ifft_inplace(n_left, num_threads);
+    n_left.resize(r - l);
+    return n_left;
+  }
+};
+
+}  // namespace impl
+
+/**
+ * \brief Multipoint evaluation of a polynomial.
+ * \ingroup conv
+ *
+ * Returns \f$f(x_i)\f$ for all points \f$x_i\f$ in `xs`, where \f$f(x)=\sum_j f_jx^j\f$.
+ *
+ * It builds the subproduct tree of \f$\prod(x-x_i)\f$ over halves of the points, then goes down the tree with middle
+ * products (the transposed algorithm of Bostan, Lecerf and Schost), which needs only one power series inverse at the
+ * root instead of a division at each node. Both children of a node share the transform of their parent. It takes
+ * \f$O(n\log^2 n)\f$ time and \f$O(n\log n)\f$ memory for \f$n\f$ points and coefficients. Short inputs are evaluated
+ * with Horner's method.
+ *
+ * With `num_threads` greater than 1, the two subtrees of each node are done concurrently, with the threads split
+ * between them.
+ *
+ * \tparam T See fft_inplace() for requirements for `T`, which must also support division.
+ */
+template <typename T>
+std::vector<T> multipoint_evaluate(const std::vector<T>& f, const std::vector<T>& xs, unsigned num_threads = 1) {
+  const std::size_t n = f.size(), m = xs.size();
+  if (n == 0 || m == 0) {
+    return std::vector<T>(m, T(0));
+  }
+  if (impl::conv_naive_is_efficient<T>(n, m)) {
+    std::vector<T> ret(m);
+    for (std::size_t i = 0; i < m; i++) {
+      T y(0);
+      for (std::size_t j = n; j-- > 0;) {
+        y = y * xs[i] + f[j];
+      }
+      ret[i] = y;
+    }
+    return ret;
+  }
+  return impl::SubproductTree<T>(xs, num_threads).evaluate(f, num_threads);
+}
+
+/**
+ * \brief Polynomial interpolation.
+ * \ingroup conv
+ *
+ * Returns the polynomial \f$f\f$ of degree less than \f$n\f$ such that \f$f(x_i)=y_i\f$, where \f$n\f$ is the number
+ * of points. `xs` and `ys` must have the same length, and the points must be distinct.
+ *
+ * By Lagrange's formula \f$f=\sum_i\frac{y_i}{M'(x_i)}\prod_{j\neq i}(x-x_j)\f$ with \f$M=\prod(x-x_i)\f$, it takes one
+ * multipoint_evaluate() of \f$M'\f$ on the subproduct tree, and then goes up the same tree combining the sums of
+ * children. It takes \f$O(n\log^2 n)\f$ time.
+ *
+ * \see multipoint_evaluate() for multithreading.
+ */
+template <typename T>
+std::vector<T> interpolate(const std::vector<T>& xs, const std::vector<T>& ys, unsigned num_threads = 1) {
+  assert(xs.size() == ys.size());
+  const std::size_t n = xs.size();
+  if (n == 0) {
+    return {};
+  }
+  impl::SubproductTree<T> tree(xs, num_threads);
+  std::vector<T> dm = impl::fps_derivative(tree.root(), n + 1);
+  std::vector<T> c = tree.evaluate(dm, num_threads);
+  for (std::size_t i = 0; i < n; i++) {
+    c[i] = ys[i] / c[i];
+  }
+  return tree.combine(c, num_threads);
+}
+
+}  // namespace cplib
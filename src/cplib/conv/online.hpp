@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "cplib/conv/conv.hpp"
+#include "cplib/conv/fft.hpp"
+#include "cplib/port/bit.hpp"
+
+namespace cplib {
+
+/**
+ * \brief Online (relaxed) convolution, for sequences whose elements are known one at a time.
+ * \ingroup conv
+ *
+ * push() takes \f$a_i\f$ and \f$b_i\f$, and returns \f$c_i=\sum_{j=0}^i a_jb_{i-j}\f$ right away, so that later
+ * elements of the inputs can depend on earlier elements of the output. For example, if \f$f=gf+h\f$ with \f$g_0=0\f$,
+ * then pushing \f$g_{i+1}\f$ and \f$f_i\f$ returns \f$\sum_{j\geq 1}g_jf_{i+1-j}\f$, which is \f$f_{i+1}-h_{i+1}\f$.
+ *
+ * Products of pairs \f$(j,k)\f$ with both indices positive are done in square blocks of power-of-two sizes \f$s\f$:
+ * \f$a[x,x+s)\times b[s,2s)\f$ and \f$a[s,2s)\times b[x,x+s)\f$ for multiples \f$x\geq s\f$ of \f$s\f$, each as soon as
+ * its last element is pushed, which is before any of its results is needed. The transforms of \f$a[s,2s)\f$ and
+ * \f$b[s,2s)\f$ are cached, and the two blocks of the same \f$x\f$ are summed on transforms, so each block of size
+ * \f$s\f$ takes 3 transforms of length \f$2s\f$. The total time for \f$n\f$ elements is \f$O(n\log^2 n)\f$, and small
+ * blocks are multiplied naively.
+ *
+ * \tparam T See fft_inplace() for requirements for `T`.
+ */
+template <typename T>
+class OnlineConvolution {
+ public:
+  using size_type = std::size_t;
+
+  /** \brief Returns the number of elements pushed. */
+  size_type size() const { return a_.size(); }
+
+  /** \brief Pushes \f$a_i\f$ and \f$b_i\f$, and returns \f$c_i\f$, where \f$i\f$ is size() before the call. */
+  T push(const T& a, const T& b) {
+    const size_type t = a_.size();
+    a_.push_back(a);
+    b_.push_back(b);
+    if (c_.size() < t * 2 + 1) {
+      c_.resize(std::max<size_type>(c_.size() * 2, 2), T(0));
+    }
+    c_[t] += t == 0 ? a * b : a * b_[0] + a_[0] * b;
+    for (size_type s = 1; (t + 1) % s == 0 && t + 1 >= s * 2; s *= 2) {
+      add_blocks(t + 1 - s, s);
+    }
+    return c_[t];
+  }
+
+ private:
+  // Blocks no larger than this are multiplied naively.
+  static constexpr size_type naive_block = 16;
+
+  // c_[i] for i>=size() only has the blocks done so far.
+  std::vector<T> a_, b_, c_;
+  // Transforms of a[s,2s) and b[s,2s) of length 2s, indexed by log2(s).
+  std::vector<std::vector<T>> a_fft_, b_fft_;
+
+  // Adds a[x,x+s)*b[s,2s), and a[s,2s)*b[x,x+s) unless x=s, to c_[x+s,x+3s-1).
+  void add_blocks(size_type x, size_type s) {
+    T* out = c_.data() + x + s;
+    if (s <= naive_block) {
+      for (size_type i = 0; i < s; i++) {
+        for (size_type k = 0; k < s; k++) {
+          out[i + k] += a_[x + i] * b_[s + k];
+        }
+      }
+      if (x != s) {
+        for (size_type i = 0; i < s; i++) {
+          for (size_type k = 0; k < s; k++) {
+            out[i + k] += a_[s + i] * b_[x + k];
+          }
+        }
+      }
+      return;
+    }
+    const int p = port::countr_zero(s);
+    if (x == s) {
+      a_fft_.resize(p + 1);
+      b_fft_.resize(p + 1);
+      a_fft_[p] = transform(a_, s, s);
+      b_fft_[p] = transform(b_, s, s);
+    }
+    std::vector<T> prod = x == s ? a_fft_[p] : transform(a_, x, s);
+    const std::vector<T>& b_fixed = b_fft_[p];
+    if (x == s) {
+      for (size_type i = 0; i < s * 2; i++) {
+        prod[i] *= b_fixed[i];
+      }
+    } else {
+      const std::vector<T> b_block = transform(b_, x, s);
+      const std::vector<T>& a_fixed = a_fft_[p];
+      for (size_type i = 0; i < s * 2; i++) {
+        prod[i] = prod[i] * b_fixed[i] + a_fixed[i] * b_block[i];
+      }
+    }
+    ifft_inplace(prod);
+    for (size_type i = 0; i + 1 < s * 2; i++) {
+      out[i] += prod[i];
+    }
+  }
+
+  // Returns the transform of v[x,x+s) of length 2s.
+  static std::vector<T> transform(const std::vector<T>& v, size_type x, size_type s) {
+    std::vector<T> ret(s * 2, T(0));
+    std::copy(v.begin() + x, v.begin() + x + s, ret.begin());
+    fft_inplace(ret);
+    return ret;
+  }
+};
+
+}  // namespace cplib
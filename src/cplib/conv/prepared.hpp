@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "cplib/conv/conv.hpp"
+#include "cplib/port/bit.hpp"
+
+namespace cplib {
+
+/**
+ * \brief Convolution with a fixed kernel, which is transformed only once.
+ * \ingroup conv
+ *
+ * convolve_inplace() transforms both arrays on every call. When the same array (the kernel) is convolved with many
+ * others, this class transforms the kernel once at a fixed FFT length, and each apply() only transforms the other
+ * array forth and back, which saves about a third of the work.
+ *
+ * Inputs no longer than max_input_size() take a single transform of length fft_size(). Longer inputs are split into
+ * blocks of max_input_size() elements, whose convolutions with the kernel are added together (overlap-add), so that
+ * the time is linear in the input length for a fixed kernel. ConvolutionStream does the same for inputs that arrive
+ * in pieces.
+ *
+ * \tparam T See fft_inplace() for requirements for `T`.
+ */
+template <typename T>
+class PreparedConvolution {
+ public:
+  using size_type = std::size_t;
+
+  /**
+   * \brief Prepares the kernel `b` so that inputs of up to `max_input_size` elements take a single transform.
+   *
+   * The FFT length is the smallest power of two no less than `max_input_size + b.size() - 1`, which must be supported
+   * by `T`. `b` must not be empty and `max_input_size` must be positive. A good choice for long inputs is a few times
+   * `b.size()`.
+   */
+  PreparedConvolution(const std::vector<T>& b, size_type max_input_size, unsigned num_threads = 1)
+      : kernel_(b), transformed_(b) {
+    assert(!b.empty() && max_input_size > 0);
+    transformed_.resize(port::bit_ceil(max_input_size + b.size() - 1), T(0));
+    fft_inplace(transformed_, num_threads);
+  }
+
+  /** \brief Returns the length of the kernel. */
+  size_type kernel_size() const { return kernel_.size(); }
+
+  /** \brief Returns the FFT length. */
+  size_type fft_size() const { return transformed_.size(); }
+
+  /**
+   * \brief Returns the maximum input length done with a single transform.
+   *
+   * This is `fft_size() - kernel_size() + 1`, which may be larger than that given to the constructor.
+   */
+  size_type max_input_size() const { return fft_size() - kernel_size() + 1; }
+
+  /**
+   * \brief Replaces `a` with its convolution with the kernel.
+   *
+   * The result has length `a.size() + kernel_size() - 1`, or is empty if `a` is empty. `a` can be of any length.
+   *
+   * Each transform can be split into `num_threads` threads, see fft_inplace().
+   */
+  void apply_inplace(std::vector<T>& a, unsigned num_threads = 1) const {
+    if (a.empty()) {
+      return;
+    }
+    if (impl::conv_naive_is_efficient<T>(a.size(), kernel_size())) {
+      impl::conv_naive_inplace(a, kernel_);
+      return;
+    }
+    if (a.size() <= max_input_size()) {
+      apply_block(a, num_threads);
+      return;
+    }
+    a = impl::conv_overlap_add(a, kernel_size(), max_input_size(),
+                               [&](std::vector<T>& x) { apply_block(x, num_threads); });
+  }
+
+  /**
+   * \brief Returns the convolution of `a` with the kernel.
+   * \see apply_inplace()
+   */
+  std::vector<T> apply(const std::vector<T>& a, unsigned num_threads = 1) const {
+    auto a_copy = a;
+    apply_inplace(a_copy, num_threads);
+    return a_copy;
+  }
+
+ private:
+  std::vector<T> kernel_, transformed_;
+
+  // Convolution of a non-empty input of at most max_input_size() elements.
+  void apply_block(std::vector<T>& a, unsigned num_threads) const {
+    const size_type out_size = a.size() + kernel_size() - 1;
+    a.resize(fft_size(), T(0));
+    fft_inplace(a, num_threads);
+    impl::conv_transformed_inplace(a, transformed_, num_threads);
+    a.resize(out_size);
+  }
+};
+
+/**
+ * \brief Streaming convolution with a fixed kernel, for inputs that arrive in pieces.
+ * \ingroup conv
+ *
+ * Input is fed with push(), and each element of the convolution is returned as soon as it no longer depends on future
+ * input. Input is buffered into blocks of PreparedConvolution::max_input_size() elements, and each block is convolved
+ * once and added to the output (overlap-add). finish() ends the input, and returns the rest of the output, which is
+ * `kernel_size() - 1` elements more than the total input unless there is no input at all. The stream can then be reused
+ * for another input.
+ *
+ * The PreparedConvolution given to the constructor must outlive the stream.
+ *
+ * \tparam T See fft_inplace() for requirements for `T`.
+ */
+template <typename T>
+class ConvolutionStream {
+ public:
+  using size_type = std::size_t;
+
+  /** \brief Creates a stream convolving with the kernel of `conv`. */
+  explicit ConvolutionStream(const PreparedConvolution<T>& conv) : conv_(&conv) {}
+
+  /** \brief Feeds more input, and returns the output that is complete, in order. */
+  std::vector<T> push(const std::vector<T>& input, unsigned num_threads = 1) {
+    pending_.insert(pending_.end(), input.begin(), input.end());
+    const size_type block = conv_->max_input_size();
+    std::vector<T> ret;
+    size_type start = 0;
+    for (; pending_.size() - start >= block; start += block) {
+      std::vector<T> buf(pending_.begin() + start, pending_.begin() + start + block);
+      emit(buf, block, ret, num_threads);
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + start);
+    return ret;
+  }
+
+  /** \brief Ends the input, and returns the rest of the output. */
+  std::vector<T> finish(unsigned num_threads = 1) {
+    std::vector<T> ret;
+    if (!pending_.empty()) {
+      std::vector<T> buf = std::move(pending_);
+      pending_.clear();
+      emit(buf, buf.size() + conv_->kernel_size() - 1, ret, num_threads);
+    } else {
+      ret = std::move(tail_);
+    }
+    tail_.clear();
+    return ret;
+  }
+
+ private:
+  const PreparedConvolution<T>* conv_;
+  // Input not yet convolved, and the part of output that still needs contributions from the next block.
+  std::vector<T> pending_, tail_;
+
+  // Convolves a block, adds the tail from the previous block, and moves the first `count` elements to `out`.
+  void emit(std::vector<T>& buf, size_type count, std::vector<T>& out, unsigned num_threads) {
+    conv_->apply_inplace(buf, num_threads);
+    for (size_type i = 0; i < tail_.size(); i++) {
+      buf[i] += tail_[i];
+    }
+    out.insert(out.end(), buf.begin(), buf.begin() + count);
+    tail_.assign(buf.begin() + count, buf.end());
+  }
+};
+
+}  // namespace cplib
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+
+#include "cplib/conv/conv.hpp"
+#include "cplib/conv/fft.hpp"
+#include "cplib/port/bit.hpp"
+
+namespace cplib {
+
+namespace impl {
+
+// Below this length naive multiplication of real numbers, which vectorizes well, is faster than real FFT.
+constexpr std::size_t conv_real_naive_threshold = 48;
+
+// Returns \omega_{2m}^{-rev(j)} for 0<=j<m, where rev reverses log2(m) bits, i.e. the inverse twiddling factors of the
+// first stage of length-2m FFT in bit-reversed order. Since rev(j)=rev(j-2^t)+m/2^{t+1} for 2^t<=j<2^{t+1}, each one
+// is the product of an earlier one and a root of unity.
+template <typename Float>
+std::vector<std::complex<Float>> real_fft_twiddles(std::size_t m) {
+  std::vector<std::complex<Float>> ret(m);
+  ret[0] = 1;
+  for (std::size_t t = 0; (std::size_t(1) << t) < m; t++) {
+    const std::complex<Float> root = std::conj(radix2_fft_root<std::complex<Float>>::get(t + 2));
+    for (std::size_t j = std::size_t(1) << t; j < (std::size_t(2) << t); j++) {
+      ret[j] = ret[j - (std::size_t(1) << t)] * root;
+    }
+  }
+  return ret;
+}
+
+// Convolution of real sequences with one complex FFT of length L and one inverse FFT of length L/2, instead of three
+// of length L, with L the smallest power of two no less than the result length, which must be at least 2.
+//
+// The two inputs are packed as the real and imaginary parts z=a+ib, so that A=(Z[k]+conj(Z[-k]))/2 and
+// B=(Z[k]-conj(Z[-k]))/2i, and thus C=AB=(Z[k]^2-conj(Z[-k])^2)/4i. Since c is real, its even and odd elements are
+// packed into one sequence w=c_even+ic_odd of length L/2, whose transform is W[k]=E[k]+iO[k] with
+// E[k]=(C[k]+C[k+L/2])/2 and O[k]=(C[k]-C[k+L/2])\omega_L^{-k}/2. In bit-reversed order C[k] and C[k+L/2] are adjacent
+// at 2j and 2j+1 where j is the position of W[k], and -k is at j^(bit_floor(j)-1) for both transforms.
+template <typename Float, typename T>
+std::vector<Float> conv_real_fft(const std::vector<T>& a, const std::vector<T>& b, unsigned num_threads) {
+  using usize = std::size_t;
+  using cf = std::complex<Float>;
+  const usize out_size = a.size() + b.size() - 1, len = port::bit_ceil(out_size), half_len = len / 2;
+  // The rounding error is relative to the larger of the two parts, so b is scaled by a power of two to about the same
+  // magnitude as a, which keeps the error relative to max|a|max|b|.
+  Float max_a = 0, max_b = 0;
+  for (const T& x : a) {
+    max_a = std::max(max_a, std::abs(Float(x)));
+  }
+  for (const T& x : b) {
+    max_b = std::max(max_b, std::abs(Float(x)));
+  }
+  const int scale = max_a > 0 && max_b > 0 ? std::ilogb(max_a) - std::ilogb(max_b) : 0;
+  const Float scale_b = std::ldexp(Float(1), scale), unscale = std::ldexp(Float(1), -scale);
+  std::vector<cf> z(len);
+  for (usize i = 0; i < a.size(); i++) {
+    z[i].real(Float(a[i]));
+  }
+  for (usize i = 0; i < b.size(); i++) {
+    z[i].imag(Float(b[i]) * scale_b);
+  }
+  fft_inplace(z, num_threads);
+  auto product = [&](usize p, usize q) {
+    const cf zp = z[p], zq = std::conj(z[q]);
+    return (zp * zp - zq * zq) * cf(0, Float(-0.25));
+  };
+  const std::vector<cf> twiddles = real_fft_twiddles<Float>(half_len);
+  std::vector<cf> w(half_len);
+  const usize chunk = std::min(half_len, fft_row_length<cf>());
+  parallel_for(0, half_len / chunk, num_threads, [&](usize c) {
+    for (usize j = c * chunk; j < (c + 1) * chunk; j++) {
+      const usize k = j == 0 ? 0 : j ^ (port::bit_floor(j) - 1);
+      if (k < j) {
+        continue;
+      }
+      // C at 2j and 2j+1, whose conjugates are C at 2k+1 and 2k, except that C[0] and C[L/2] are real.
+      const cf c0 = product(j * 2, j == 0 ? 0 : k * 2 + 1), c1 = product(j * 2 + 1, j == 0 ? 1 : k * 2);
+      w[j] = (c0 + c1 + (c0 - c1) * twiddles[j] * cf(0, 1)) * Float(0.5);
+      if (k != j) {
+        const cf d0 = std::conj(c1), d1 = std::conj(c0);
+        w[k] = (d0 + d1 + (d0 - d1) * twiddles[k] * cf(0, 1)) * Float(0.5);
+      }
+    }
+  });
+  z = {};
+  ifft_inplace(w, num_threads);
+  std::vector<Float> ret(out_size);
+  for (usize i = 0; i < out_size; i++) {
+    ret[i] = (i % 2 == 0 ? w[i / 2].real() : w[i / 2].imag()) * unscale;
+  }
+  return ret;
+}
+
+}  // namespace impl
+
+/**
+ * \brief Returns the convolution of two real or integer sequences.
+ * \ingroup conv
+ *
+ * Unlike convolve() over `std::complex<double>`, this takes advantage of the inputs and the result being real. The
+ * two inputs are packed into one complex sequence, which takes one transform, and the result is packed into one of
+ * half the length, so it takes half as many butterflies and half the memory.
+ *
+ * If `T` is a floating-point type, computation is done in `std::complex<T>`. If `T` is an integer type, it is done in
+ * `std::complex<double>` and each element of the result is rounded to the nearest integer. The error of each element
+ * is at most about \f$3\epsilon\log_2 L\max|a_i|\max|b_j|\min\{N_1,N_2\}\f$, where \f$L\f$ is the FFT length and
+ * \f$N_1,N_2\f$ are the lengths of the two sequences, and is usually much smaller for random inputs. Thus the
+ * result of integers is exact if \f$\max|a_i|\max|b_j|\min\{N_1,N_2\}\leq 10^{13}\f$ for lengths up to \f$10^6\f$ or
+ * so.
+ *
+ * Short sequences are multiplied naively in `T`, which is exact for integers as long as there is no overflow.
+ *
+ * See fft_inplace() for multithreading.
+ *
+ * \tparam T A floating-point or integer type.
+ */
+template <typename T>
+std::vector<T> convolve_real(const std::vector<T>& a, const std::vector<T>& b, unsigned num_threads = 1) {
+  static_assert(std::is_arithmetic_v<T>);
+  if (a.empty() || b.empty()) {
+    return {};
+  }
+  if (std::min(a.size(), b.size()) <= impl::conv_real_naive_threshold) {
+    std::vector<T> ret = a;
+    impl::conv_naive_inplace(ret, b);
+    return ret;
+  }
+  if constexpr (std::is_floating_point_v<T>) {
+    return impl::conv_real_fft<T>(a, b, num_threads);
+  } else {
+    std::vector<double> c = impl::conv_real_fft<double>(a, b, num_threads);
+    std::vector<T> ret(c.size());
+    for (std::size_t i = 0; i < c.size(); i++) {
+      ret[i] = T(std::llround(c[i]));
+    }
+    return ret;
+  }
+}
+
+}  // namespace cplib
@@ -197,7 +197,7 @@ class MontgomeryModInt {
   using mr_type = typename Context::mr_type;
   using int_double_t = typename mr_type::int_double_t;
 
-  MontgomeryModInt() : val_(0) {}
+  constexpr MontgomeryModInt() : val_(0) {}
 
   /**
    * \brief Converts a plain integer to a Montgomery modular integer.
@@ -249,6 +249,27 @@ class MontgomeryModInt {
   /** \brief Returns the modulus. */
   static constexpr int_type mod() { return mr().mod(); }
 
+  /**
+   * \brief Returns the underlying value in Montgomery form.
+   *
+   * It is in \f$[0,2N)\f$ if \f$N<R/4\f$, or \f$[0,N)\f$ otherwise. Useful for algorithms that do their own lazy
+   * reduction.
+   */
+  constexpr int_type raw() const { return val_; }
+
+  /**
+   * \brief Constructs from an underlying value in Montgomery form, without any reduction.
+   *
+   * Arithmetic operators expect the value in the same range as raw(). When \f$N<R/4\f$, multiplication additionally
+   * accepts a value in \f$[0,4N)\f$ if the other operand is in \f$[0,N)\f$, since the result is still less than
+   * \f$(4N\cdot N+NR)/R<2N\f$.
+   */
+  static constexpr mint from_raw(int_type x) {
+    mint ret;
+    ret.val_ = x;
+    return ret;
+  }
+
   mint& operator++() {
     val_ = mr().add(val_, mr().mbase());
     return *this;
@@ -309,12 +330,6 @@ class MontgomeryModInt {
     ~Guard() { Context::pop_mod(); }
   };
 
-  static constexpr mint from_raw(int_type x) {
-    mint ret;
-    ret.val_ = x;
-    return ret;
-  }
-
   static constexpr const mr_type& mr() { return Context::montgomery_reduction(); }
 };
 
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "cplib/num/mmint.hpp"
+
+#pragma GCC push_options
+#ifndef _CPLIB_NO_FORCE_AVX2_
+#pragma GCC target("avx2")
+#endif
+
+#if defined(__AVX2__) || !defined(_CPLIB_NO_FORCE_AVX2_)
+
+namespace cplib::impl {
+
+// Eight MMInt<Mod> packed in an AVX2 register.
+//
+// Values are in [0,2N) just like MontgomeryModInt with N<R/4, so that they can be directly loaded from and stored to
+// arrays of MMInt<Mod>. Multiplication computes hi(a*b)-hi(m*N)+N where m=lo(a*b)*N^-1, which is exactly the
+// Montgomery reduction since lo(a*b)=lo(m*N), and only uses the 32x32->64 multiplication available in AVX2.
+template <uint32_t Mod>
+class MMIntx8 {
+ public:
+  using mint = MMInt<Mod>;
+  static_assert(Mod <= std::numeric_limits<uint32_t>::max() / 4);
+  static_assert(sizeof(mint) == sizeof(uint32_t));
+
+  MMIntx8() = default;
+
+  explicit MMIntx8(__m256i v) : v_(v) {}
+
+  explicit MMIntx8(const mint& x) {
+    uint32_t raw;
+    std::memcpy(&raw, &x, sizeof(raw));
+    v_ = _mm256_set1_epi32(raw);
+  }
+
+  static MMIntx8 load(const mint* p) { return MMIntx8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))); }
+
+  void store(mint* p) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v_); }
+
+  __m256i data() const { return v_; }
+
+  MMIntx8 operator+(const MMIntx8& rhs) const {
+    __m256i r = _mm256_add_epi32(v_, rhs.v_);
+    return MMIntx8(_mm256_min_epu32(r, _mm256_sub_epi32(r, mod2())));
+  }
+
+  MMIntx8& operator+=(const MMIntx8& rhs) { return *this = *this + rhs; }
+
+  MMIntx8 operator-(const MMIntx8& rhs) const {
+    __m256i r = _mm256_sub_epi32(v_, rhs.v_);
+    return MMIntx8(_mm256_min_epu32(r, _mm256_add_epi32(r, mod2())));
+  }
+
+  MMIntx8& operator-=(const MMIntx8& rhs) { return *this = *this - rhs; }
+
+  MMIntx8 operator*(const MMIntx8& rhs) const {
+    __m256i prod_even = _mm256_mul_epu32(v_, rhs.v_);
+    __m256i prod_odd = _mm256_mul_epu32(_mm256_srli_epi64(v_, 32), _mm256_srli_epi64(rhs.v_, 32));
+    __m256i q_even = _mm256_mul_epu32(_mm256_mul_epu32(prod_even, mod_inv()), mod());
+    __m256i q_odd = _mm256_mul_epu32(_mm256_mul_epu32(prod_odd, mod_inv()), mod());
+    __m256i prod_hi = _mm256_blend_epi32(_mm256_srli_epi64(prod_even, 32), prod_odd, 0b10101010);
+    __m256i q_hi = _mm256_blend_epi32(_mm256_srli_epi64(q_even, 32), q_odd, 0b10101010);
+    return MMIntx8(_mm256_add_epi32(_mm256_sub_epi32(prod_hi, q_hi), mod()));
+  }
+
+  MMIntx8& operator*=(const MMIntx8& rhs) { return *this = *this * rhs; }
+
+ private:
+  __m256i v_;
+
+  // N^-1 mod 2^32 by Hensel lifting.
+  static constexpr uint32_t mod_inv_ = [] {
+    uint32_t y = 1;
+    for (int i = 0; i < 5; i++) {
+      y *= 2 - Mod * y;
+    }
+    return y;
+  }();
+
+  static __m256i mod() { return _mm256_set1_epi32(Mod); }
+
+  static __m256i mod2() { return _mm256_set1_epi32(Mod * 2); }
+
+  static __m256i mod_inv() { return _mm256_set1_epi32(mod_inv_); }
+};
+
+}  // namespace cplib::impl
+
+#endif
+
+#pragma GCC pop_options
@@ -8,6 +8,7 @@
 #include "cplib/num/mmint.hpp"
 #include "cplib/num/pow.hpp"
 #include "cplib/num/prime.hpp"
+#include "cplib/num/primitive_root_constexpr.hpp"
 
 namespace cplib {
 
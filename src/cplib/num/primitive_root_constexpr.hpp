@@ -0,0 +1,69 @@
+#pragma once
+
+#include <limits>
+#include <type_traits>
+
+#include "cplib/port/bit.hpp"
+#include "cplib/utils/type.hpp"
+
+namespace cplib {
+
+namespace impl {
+
+template <typename T>
+constexpr T pow_mod_constexpr(T a, T e, T n) {
+  using U = make_double_width_t<T>;
+  T ret = 1 % n;
+  for (; e; e >>= 1) {
+    if (e & 1) {
+      ret = T(U(ret) * a % n);
+    }
+    a = T(U(a) * a % n);
+  }
+  return ret;
+}
+
+}  // namespace impl
+
+/**
+ * \brief Primitive root modulo a prime number, computed at compile time.
+ * \ingroup num
+ *
+ * Returns the smallest primitive root modulo the prime \f$p\f$, and can be used in constant expressions. Prime factors
+ * of \f$p-1\f$ are found by trial division after removing all factors of 2, which is fast for FFT-friendly primes
+ * \f$p=c\cdot 2^k+1\f$ with small \f$c\f$, but may exceed the limit of constant evaluation if \f$c\f$ has two large
+ * prime factors. Use primitive_root_prime() for general primes at runtime.
+ *
+ * \tparam T An unsigned integer type.
+ */
+template <typename T, std::enable_if_t<std::is_unsigned_v<T>>* = nullptr>
+constexpr T primitive_root_prime_constexpr(T p) {
+  if (p == 2) {
+    return 1;
+  }
+  T factors[std::numeric_limits<T>::digits] = {2};
+  int num_factors = 1;
+  T c = (p - 1) >> port::countr_zero(T(p - 1));
+  for (T d = 3; d <= c / d; d += 2) {
+    if (c % d == 0) {
+      factors[num_factors++] = d;
+      while (c % d == 0) {
+        c /= d;
+      }
+    }
+  }
+  if (c > 1) {
+    factors[num_factors++] = c;
+  }
+  for (T g = 2;; g++) {
+    bool ok = true;
+    for (int i = 0; i < num_factors && ok; i++) {
+      ok = impl::pow_mod_constexpr<T>(g, (p - 1) / factors[i], p) != 1;
+    }
+    if (ok) {
+      return g;
+    }
+  }
+}
+
+}  // namespace cplib
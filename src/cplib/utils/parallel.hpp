@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cplib::impl {
+
+// Calls f(i) for all i in [begin,end), split into contiguous chunks over at most num_threads threads, one of which is
+// the calling thread. Returns after all calls are done.
+template <typename Func>
+void parallel_for(std::size_t begin, std::size_t end, unsigned num_threads, Func&& f) {
+  if (end <= begin) {
+    return;
+  }
+  const std::size_t n = end - begin;
+  const std::size_t chunks = std::min<std::size_t>(std::max(num_threads, 1u), n);
+  auto run_chunk = [&](std::size_t k) {
+    for (std::size_t i = begin + n * k / chunks; i < begin + n * (k + 1) / chunks; i++) {
+      f(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(chunks - 1);
+  for (std::size_t k = 1; k < chunks; k++) {
+    threads.emplace_back(run_chunk, k);
+  }
+  run_chunk(0);
+  for (std::thread& t : threads) {
+    t.join();
+  }
+}
+
+// Calls f() and g() concurrently, where g() runs on a new thread. Returns after both are done.
+template <typename F, typename G>
+void parallel_invoke(F&& f, G&& g) {
+  std::thread t(std::forward<G>(g));
+  f();
+  t.join();
+}
+
+}  // namespace cplib::impl
@@ -26,4 +26,87 @@ TEST_CASE("Large anymod convolution", "[anymod]") {
   for (int i = 0; i < N * 2 - 1; i++) {
     CHECK(a[i] == (unsigned long long)min(i + 1, N * 2 - 1 - i) * X2 % mint::mod());
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Multithreaded anymod convolution", "[anymod]") {
+  const int N = 30000;
+  vector<mint> a, b;
+  for (int i = 0; i < N; i++) {
+    a.emplace_back(1000000006 - i);
+    b.emplace_back(i * 9973);
+  }
+  CHECK(convolve_any_modint(a, b, 4) == convolve_any_modint(a, b));
+}
+
+TEST_CASE("Anymod squaring", "[anymod]") {
+  for (int n : {1, 20, 1000}) {
+    vector<mint> a = make_sequence_near_modulus<mint>(n, 12345), b = a;
+    vector<mint> expected = convolve_any_modint(a, b);
+    CHECK(square_any_modint(a) == expected);
+    CHECK(convolve_any_modint(a, a) == expected);
+    vector<mint> c = a;
+    convolve_any_modint_inplace(c, c);
+    CHECK(c == expected);
+  }
+}
+
+TEST_CASE("Anymod convolution across algorithms", "[anymod]") {
+  // Covers naive, Karatsuba and FFT convolution, including unbalanced lengths.
+  for (auto [n, m] : vector<pair<int, int>>{{20, 20}, {100, 90}, {150, 3000}, {300, 400}}) {
+    vector<mint> a = make_sequence_near_modulus<mint>(n, 12345), b;
+    for (int i = 0; i < m; i++) {
+      b.emplace_back(i * 999983 + 1);
+    }
+    vector<mint> expected(n + m - 1);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < m; j++) {
+        expected[i + j] += a[i] * b[j];
+      }
+    }
+    CHECK(convolve_any_modint(a, b) == expected);
+    CHECK(convolve_any_modint(b, a) == expected);
+  }
+}
+
+TEST_CASE("Anymod convolution with two and three primes", "[anymod]") {
+  using mint1 = MMInt<167772161>;
+  using mint2 = MMInt<469762049>;
+  using mint3 = MMInt<754974721>;
+  using mint64_1 = MMInt64<4512606826625236993>;
+  using mint64_2 = MMInt64<4242390848983007233>;
+  using mint_large = MMInt<4294967291>;
+  vector<mint> a = make_sequence_near_modulus<mint>(2000, 12345), b;
+  vector<mint_large> c = make_sequence_near_modulus<mint_large>(2000, 12345),
+                     d = make_sequence_near_modulus<mint_large>(1500, 999983);
+  for (int i = 0; i < 1500; i++) {
+    b.emplace_back(i * 999983 + 1);
+  }
+  auto expected = impl::convolve_with_two_modints<mint, mint, mint64_1, mint64_2>(a, b, 1);
+  CHECK(impl::convolve_with_three_modints<mint, mint, mint1, mint2, mint3>(a, b, 1) == expected);
+  CHECK(convolve_any_modint(a, b) == expected);
+  auto expected_large = impl::convolve_with_two_modints<mint_large, mint_large, mint64_1, mint64_2>(c, d, 1);
+  CHECK(impl::convolve_with_three_modints<mint_large, mint_large, mint1, mint2, mint3>(c, d, 1) == expected_large);
+  CHECK(convolve_any_modint(c, d) == expected_large);
+}
+
+TEST_CASE("Anymod convolution with split double FFT", "[anymod]") {
+  using mint64_1 = MMInt64<4512606826625236993>;
+  using mint64_2 = MMInt64<4242390848983007233>;
+  using mint_large = MMInt<4294967291>;
+  // The largest inputs allowed by the error bound, with values of the largest magnitude in balanced representation.
+  const size_t n = 1 << 15;
+  REQUIRE(impl::split_complex_shift(mint::mod(), n, n * 2) == 15);
+  CHECK(impl::split_complex_shift(mint::mod(), n * 2, n * 4) == 0);
+  vector<mint> a(n, mint(500000003)), b(n, mint(500000004));
+  auto expected = impl::convolve_with_two_modints<mint, mint, mint64_1, mint64_2>(a, b, 1);
+  CHECK(impl::convolve_with_split_complex(a, b, 15, 1) == expected);
+  expected = impl::convolve_with_two_modints<mint, mint, mint64_1, mint64_2>(a, a, 1);
+  CHECK(impl::convolve_with_split_complex(a, a, 15, 1) == expected);
+  vector<mint_large> c = make_sequence_near_modulus<mint_large>(2000, 12345), d;
+  for (int i = 0; i < 1500; i++) {
+    d.emplace_back(i * 999983 + 1);
+  }
+  REQUIRE(impl::split_complex_shift(mint_large::mod(), d.size(), 4096) == 16);
+  auto expected_large = impl::convolve_with_two_modints<mint_large, mint_large, mint64_1, mint64_2>(c, d, 1);
+  CHECK(impl::convolve_with_split_complex(c, d, 16, 1) == expected_large);
+}
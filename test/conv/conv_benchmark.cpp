@@ -0,0 +1,243 @@
+#include <complex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "cplib/conv/anymod.hpp"
+#include "cplib/conv/conv.hpp"
+#include "cplib/conv/fps.hpp"
+#include "cplib/conv/linear_recurrence.hpp"
+#include "cplib/conv/multipoint.hpp"
+#include "cplib/conv/online.hpp"
+#include "cplib/conv/real.hpp"
+#include "cplib/num/mmint.hpp"
+#include "cplib/port/bit.hpp"
+using namespace std;
+using namespace cplib;
+using mint = MMInt<998244353>;
+using mint64 = MMInt64<4512606826625236993>;
+using cdouble = complex<double>;
+
+// Benchmarks for choosing the thresholds in impl::conv_thresholds() and impl::anymod_conv_thresholds(). They are
+// hidden from the default test run, use `./run_tests "[benchmark]"` to run them.
+
+namespace {
+
+template <typename T>
+vector<T> random_vec(size_t n) {
+  static mt19937 rng(12345);
+  vector<T> ret;
+  for (size_t i = 0; i < n; i++) {
+    if constexpr (impl::is_complex_v<T>) {
+      ret.emplace_back(rng() % 1024, rng() % 1024);
+    } else {
+      ret.emplace_back(rng());
+    }
+  }
+  return ret;
+}
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("Benchmark convolution of equal lengths", "[.][benchmark]", mint, mint64, cdouble) {
+  for (size_t n : {8, 16, 24, 32, 48, 64, 96, 128}) {
+    vector<TestType> a = random_vec<TestType>(n), b = random_vec<TestType>(n);
+    string suffix = " " + to_string(n);
+    BENCHMARK("naive" + suffix) {
+      auto c = a;
+      impl::conv_naive_inplace(c, b);
+      return c;
+    };
+    BENCHMARK("karatsuba" + suffix) {
+      auto c = a;
+      impl::conv_karatsuba_inplace(c, b);
+      return c;
+    };
+    BENCHMARK("fft" + suffix) {
+      auto c = a, d = b;
+      impl::conv_fft_inplace2(c, d, 1);
+      return c;
+    };
+  }
+}
+
+TEMPLATE_TEST_CASE("Benchmark convolution of unequal lengths", "[.][benchmark]", mint, mint64, cdouble) {
+  for (size_t ratio : {2, 4, 6, 8, 16, 64}) {
+    for (size_t n : {300, 3000}) {
+      vector<TestType> a = random_vec<TestType>(n * ratio), b = random_vec<TestType>(n);
+      string suffix = " " + to_string(n) + "x" + to_string(n * ratio);
+      BENCHMARK("fft" + suffix) {
+        auto c = a, d = b;
+        impl::conv_fft_inplace2(c, d, 1);
+        return c;
+      };
+      BENCHMARK("blocked fft" + suffix) {
+        auto c = a;
+        impl::conv_fft_blocked_inplace(c, b, 1);
+        return c;
+      };
+    }
+  }
+}
+
+TEMPLATE_TEST_CASE("Benchmark batched convolution", "[.][benchmark]", mint, mint64, cdouble) {
+  for (size_t n : {64, 256, 512}) {
+    vector<vector<TestType>> a, b;
+    for (size_t i = 0; i < (1 << 16) / n; i++) {
+      a.push_back(random_vec<TestType>(n));
+      b.push_back(random_vec<TestType>(n));
+    }
+    string suffix = " " + to_string(a.size()) + "x" + to_string(n);
+    BENCHMARK("convolve" + suffix) {
+      vector<vector<TestType>> c;
+      for (size_t i = 0; i < a.size(); i++) {
+        c.push_back(convolve(a[i], b[i]));
+      }
+      return c;
+    };
+    BENCHMARK("convolve_batch" + suffix) { return convolve_batch(a, b); };
+  }
+}
+
+TEST_CASE("Benchmark anymod convolution", "[.][benchmark]") {
+  using mint = MMInt<1000000007>;
+  for (size_t n : {16, 32, 64, 128, 192, 256, 384, 512, 768, 1024}) {
+    vector<mint> a = random_vec<mint>(n), b = random_vec<mint>(n);
+    string suffix = " " + to_string(n);
+    BENCHMARK("naive" + suffix) {
+      auto c = a;
+      impl::conv_naive_inplace(c, b);
+      return c;
+    };
+    BENCHMARK("karatsuba" + suffix) {
+      auto c = a;
+      impl::conv_karatsuba_inplace(c, b);
+      return c;
+    };
+    BENCHMARK("fft" + suffix) { return impl::convolve_any_modint_fft(a, b, 1); };
+  }
+}
+
+TEST_CASE("Benchmark anymod convolution engines", "[.][benchmark]") {
+  using mint = MMInt<1000000007>;
+  for (size_t n : {1000, 10000, 100000, 1000000}) {
+    vector<mint> a = random_vec<mint>(n), b = random_vec<mint>(n);
+    string suffix = " " + to_string(n);
+    BENCHMARK("two 64-bit primes" + suffix) {
+      return impl::convolve_with_two_modints<mint, mint, MMInt64<4512606826625236993>, MMInt64<4242390848983007233>>(
+          a, b, 1);
+    };
+    BENCHMARK("three 32-bit primes" + suffix) {
+      return impl::convolve_with_three_modints<mint, mint, MMInt<167772161>, MMInt<469762049>, MMInt<754974721>>(
+          a, b, 1);
+    };
+    if (int shift = impl::split_complex_shift(mint::mod(), n, port::bit_ceil(n * 2 - 1))) {
+      BENCHMARK("split double FFT" + suffix) { return impl::convolve_with_split_complex(a, b, shift, 1); };
+    }
+  }
+}
+
+TEST_CASE("Benchmark real convolution", "[.][benchmark]") {
+  for (size_t n : {16, 32, 48, 64, 96, 1000, 100000}) {
+    vector<double> a, b;
+    for (const cdouble& x : random_vec<cdouble>(n)) {
+      a.push_back(x.real());
+      b.push_back(x.imag());
+    }
+    vector<cdouble> ac(a.begin(), a.end()), bc(b.begin(), b.end());
+    string suffix = " " + to_string(n);
+    if (n <= 1000) {
+      BENCHMARK("naive" + suffix) {
+        auto c = a;
+        impl::conv_naive_inplace(c, b);
+        return c;
+      };
+    }
+    BENCHMARK("real fft" + suffix) { return impl::conv_real_fft<double>(a, b, 1); };
+    BENCHMARK("complex fft" + suffix) {
+      auto c = ac, d = bc;
+      impl::conv_fft_inplace2(c, d, 1);
+      return c;
+    };
+  }
+}
+
+TEMPLATE_TEST_CASE("Benchmark mixed-radix convolution", "[.][benchmark]", MMInt<754974721>, MMInt<469762049>,
+                   MMInt64<4512606826625236993>) {
+  for (size_t out_size : {2253, 36045, 576717}) {
+    vector<TestType> a = random_vec<TestType>(out_size / 2 + 1), b = random_vec<TestType>(out_size / 2);
+    string suffix = " " + to_string(out_size);
+    BENCHMARK("power of two" + suffix) {
+      auto c = a, d = b;
+      impl::conv_cyclic_inplace2(c, d, port::bit_ceil(out_size), 1);
+      return c;
+    };
+    for (size_t r = 3; r <= impl::conv_max_radix; r += 2) {
+      if (impl::odd_radix_fft_root<TestType>::odd_part % r == 0) {
+        BENCHMARK("radix " + to_string(r) + suffix) {
+          auto c = a, d = b;
+          impl::conv_mixed_radix_inplace2(c, d, r, port::bit_ceil((out_size + r - 1) / r), 1);
+          return c;
+        };
+      }
+    }
+  }
+}
+
+TEMPLATE_TEST_CASE("Benchmark power series operations", "[.][benchmark]", mint, mint64) {
+  for (size_t n : {1000, 1 << 16, 1 << 20}) {
+    vector<TestType> a = random_vec<TestType>(n), b = random_vec<TestType>(n);
+    vector<TestType> a0 = a, a1 = a;
+    a0[0] = TestType(0);
+    a1[0] = TestType(1);
+    string suffix = " " + to_string(n);
+    BENCHMARK("convolve" + suffix) { return convolve(a, b); };
+    BENCHMARK("fps_inv" + suffix) { return fps_inv(a, n); };
+    BENCHMARK("fps_log" + suffix) { return fps_log(a1, n); };
+    BENCHMARK("fps_exp" + suffix) { return fps_exp(a0, n); };
+    BENCHMARK("fps_sqrt" + suffix) { return fps_sqrt(a1, n); };
+  }
+}
+
+TEMPLATE_TEST_CASE("Benchmark multipoint evaluation", "[.][benchmark]", mint, mint64) {
+  for (size_t n : {1000, 10000, 100000}) {
+    // Points must be distinct for interpolation.
+    vector<TestType> f = random_vec<TestType>(n), xs;
+    for (size_t i = 0; i < n; i++) {
+      xs.emplace_back(int(i * 3 + 1));
+    }
+    string suffix = " " + to_string(n);
+    BENCHMARK("convolve" + suffix) { return convolve(f, xs); };
+    BENCHMARK("multipoint_evaluate" + suffix) { return multipoint_evaluate(f, xs); };
+    BENCHMARK("interpolate" + suffix) { return interpolate(xs, f); };
+  }
+}
+
+TEMPLATE_TEST_CASE("Benchmark online convolution", "[.][benchmark]", mint, mint64) {
+  for (size_t n : {1000, 1 << 16, 1 << 20}) {
+    vector<TestType> a = random_vec<TestType>(n), b = random_vec<TestType>(n);
+    string suffix = " " + to_string(n);
+    BENCHMARK("convolve" + suffix) { return convolve(a, b); };
+    BENCHMARK("online" + suffix) {
+      OnlineConvolution<TestType> conv;
+      TestType sum(0);
+      for (size_t i = 0; i < n; i++) {
+        sum += conv.push(a[i], b[i]);
+      }
+      return sum;
+    };
+  }
+}
+
+TEMPLATE_TEST_CASE("Benchmark linear recurrence", "[.][benchmark]", mint, mint64) {
+  for (size_t d : {1000, 1 << 16}) {
+    vector<TestType> a = random_vec<TestType>(d), q = random_vec<TestType>(d + 1);
+    q[0] = TestType(1);
+    string suffix = " " + to_string(d);
+    BENCHMARK("convolve" + suffix) { return convolve(a, q); };
+    BENCHMARK("linear_recurrence_kth_term" + suffix) { return linear_recurrence_kth_term(a, q, 1000000000000000000); };
+  }
+}
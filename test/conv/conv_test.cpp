@@ -1,11 +1,20 @@
 #include "cplib/conv/conv.hpp"
 
+#include <complex>
+#include <deque>
+#include <thread>
+#include <tuple>
+
+#include "catch2/catch_template_test_macros.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "cplib/num/mmint.hpp"
+#include "cplib/num/pow.hpp"
 #include "utils.hpp"
 using namespace std;
 using namespace cplib;
 using mint = MMInt<998244353>;
+using mint64 = MMInt64<4512606826625236993>;
+using cdouble = complex<double>;
 
 TEST_CASE("Small convolution", "[conv]") {
   vector<int> a{1, 2, 3, 4}, b{5, 6, 7, 8, 9};
@@ -29,4 +38,328 @@ TEST_CASE("Large convolution", "[conv]") {
   for (int i = 456; i < 578; i++) {
     CHECK(a[i] == 578 - i);
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Convolution with varying sizes", "[conv]") {
+  // Alternate between growing and shrinking sizes, so that cached twiddling factors are both extended and reused.
+  for (int n : {40, 300, 1000, 70, 5000, 100}) {
+    vector<mint> a, b;
+    for (int i = 0; i < n; i++) {
+      a.emplace_back(i * 7 + 1);
+      b.emplace_back(n - i);
+    }
+    vector<mint> expected(n * 2 - 1);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        expected[i + j] += a[i] * b[j];
+      }
+    }
+    CHECK(convolve(a, b) == expected);
+  }
+}
+
+TEST_CASE("FFT on contiguous and non-contiguous ranges", "[conv]") {
+  // Contiguous ranges may use a vectorized kernel, which must agree with the scalar one used for std::deque.
+  for (int n : {1, 2, 4, 8, 16, 64, 1024}) {
+    vector<mint> a;
+    for (int i = 0; i < n; i++) {
+      a.emplace_back(i * i + 12345);
+    }
+    vector<mint> v = a;
+    deque<mint> d(a.begin(), a.end());
+    fft_inplace(v);
+    fft_inplace(d.begin(), d.end());
+    CHECK(equal(v.begin(), v.end(), d.begin()));
+    mint sum(0);
+    for (const mint& x : a) {
+      sum += x;
+    }
+    CHECK(v[0] == sum);
+    ifft_inplace(v);
+    ifft_inplace(d.begin(), d.end());
+    CHECK(v == a);
+    CHECK(equal(a.begin(), a.end(), d.begin()));
+  }
+}
+
+TEMPLATE_TEST_CASE("Lazily reduced FFT keeps values in range", "[conv]", mint, mint64) {
+  // Largest raw values in [0,2N) stress the lazy reduction, and results must still be in [0,2N).
+  using T = TestType;
+  const auto mod2 = T::mod() * 2;
+  for (int n : {1, 2, 4, 16, 32, 256, 2048}) {
+    vector<T> a;
+    for (int i = 0; i < n; i++) {
+      a.push_back(i % 3 == 0 ? T::from_raw(mod2 - 1) : T::from_raw(mod2 - 1 - i));
+    }
+    vector<T> v = a;
+    fft_inplace(v);
+    CHECK(all_of(v.begin(), v.end(), [&](const T& x) { return x.raw() < mod2; }));
+    ifft_inplace(v);
+    CHECK(all_of(v.begin(), v.end(), [&](const T& x) { return x.raw() < mod2; }));
+    CHECK(v == a);
+  }
+}
+
+TEMPLATE_TEST_CASE("Naive convolution with deferred reduction", "[conv]", mint, MMInt<3>, MMInt<1073741789>, mint64,
+                   MMInt64<4611686018427387847>) {
+  // Values close to the modulus and long sums make the unreduced sums as large as possible.
+  for (auto [n, m] : vector<pair<int, int>>{{1, 1}, {3, 17}, {40, 40}, {1000, 5}, {300, 200}}) {
+    vector<TestType> a, b;
+    for (int i = 0; i < n; i++) {
+      a.emplace_back(-1 - i % 3);
+    }
+    for (int i = 0; i < m; i++) {
+      b.emplace_back(i % 5 == 0 ? i : -1 - i);
+    }
+    vector<TestType> expected(n + m - 1);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < m; j++) {
+        expected[i + j] += a[i] * b[j];
+      }
+    }
+    vector<TestType> c = a;
+    impl::conv_naive_inplace(c, b);
+    CHECK(c == expected);
+  }
+}
+
+TEMPLATE_TEST_CASE("FFT modulo other FFT-friendly primes", "[conv]", MMInt<167772161>, MMInt<469762049>,
+                   MMInt<754974721>, MMInt64<4242390848983007233>) {
+  using root = radix2_fft_root<TestType>;
+  static_assert(root::max_log >= 24);
+  for (int n = 1; n <= root::max_log; n++) {
+    CHECK(root::get(n) * root::get(n) == root::get(n - 1));
+  }
+  CHECK(root::get(1) == TestType(-1));
+  vector<TestType> a = make_sequence<TestType>(300, 3), b = make_sequence<TestType>(200, 1);
+  vector<TestType> expected = a;
+  impl::conv_naive_inplace(expected, b);
+  CHECK(convolve(a, b) == expected);
+}
+
+TEMPLATE_TEST_CASE("Mixed-radix convolution", "[conv]", MMInt<167772161>, MMInt<469762049>, MMInt<754974721>,
+                   MMInt64<4512606826625236993>) {
+  constexpr uint64_t odd_part = impl::odd_radix_fft_root<TestType>::odd_part;
+  vector<TestType> a = make_sequence<TestType>(700, 3), b = make_sequence<TestType>(500, 1);
+  vector<TestType> expected = a, expected_square = a;
+  impl::conv_naive_inplace(expected, b);
+  impl::square_naive_inplace(expected_square);
+  for (size_t r = 3; r <= impl::conv_max_radix; r += 2) {
+    if (odd_part % r != 0) {
+      continue;
+    }
+    const TestType z = impl::odd_radix_fft_root<TestType>::get(unsigned(r), 8);
+    CHECK(pow(z, r * 256) == TestType(1));
+    CHECK(pow(z, r * 128) != TestType(1));
+    CHECK(pow(z, 256) != TestType(1));
+    auto c = a, d = b;
+    impl::conv_mixed_radix_inplace2(c, d, r, port::bit_ceil((expected.size() + r - 1) / r), 1);
+    c.resize(expected.size());
+    CHECK(c == expected);
+    c = a;
+    impl::conv_mixed_radix_inplace2(c, c, r, port::bit_ceil((expected_square.size() + r - 1) / r), 4);
+    c.resize(expected_square.size());
+    CHECK(c == expected_square);
+  }
+  // 1199 terms take 3*512 or 5*256 instead of 2048 if the modulus allows.
+  const impl::ConvFftLength fl = impl::conv_fft_length<TestType>(a.size() + b.size() - 1);
+  CHECK(fl.radix == (odd_part % 5 == 0 ? 5 : odd_part % 3 == 0 ? 3 : 1));
+  CHECK(convolve(a, b) == expected);
+  CHECK(square(a) == expected_square);
+}
+
+TEST_CASE("Mixed-radix convolution longer than the largest power of two", "[conv]") {
+  // 7681=15*2^9+1 has no 2^11-th root of unity, so 1099 terms must take 3*512 or 5*256.
+  using mint_small = MMInt<7681>;
+  vector<mint_small> a = make_sequence<mint_small>(600, 3), b = make_sequence<mint_small>(500, 1), expected = a;
+  impl::conv_naive_inplace(expected, b);
+  CHECK(impl::conv_fft_length<mint_small>(expected.size()).radix != 1);
+  CHECK(convolve(a, b) == expected);
+}
+
+TEST_CASE("Convolution larger than FFT cache blocks", "[conv]") {
+  // The padded length 2^17 exceeds the cache block size, so the transform is done column by column then row by row.
+  const int N = 40000, M = 50000;
+  vector<int> a(N, 1), b(M, 1);
+  vector<mint> am = from_int_vec<mint>(a), bm = from_int_vec<mint>(b);
+  convolve_inplace2(am, bm);
+  a = to_int_vec(am);
+  REQUIRE(a.size() == N + M - 1);
+  bool ok = true;
+  for (int i = 0; i < N + M - 1; i++) {
+    ok &= a[i] == min({i + 1, N, N + M - 1 - i});
+  }
+  CHECK(ok);
+}
+
+TEST_CASE("Multithreaded convolution", "[conv]") {
+  const int N = 70000, M = 90000;
+  vector<mint> a, b;
+  for (int i = 0; i < N; i++) {
+    a.emplace_back(i * 3 + 1);
+  }
+  for (int i = 0; i < M; i++) {
+    b.emplace_back(i ^ 12345);
+  }
+  vector<mint> expected = convolve(a, b);
+  for (unsigned num_threads : {2, 3, 8}) {
+    CHECK(convolve(a, b, num_threads) == expected);
+  }
+}
+
+TEST_CASE("Convolutions from concurrent threads", "[conv]") {
+  // A modulus not used by other tests, so that the threads start with an empty cache of twiddling factors and grow it
+  // to different lengths at the same time.
+  using mint7 = MMInt<7340033>;
+  const vector<size_t> sizes{100, 3000, 20000, 130000};
+  const int num_workers = 4;
+  vector<vector<vector<mint7>>> results(num_workers);
+  auto make_inputs = [](int t, size_t n) {
+    vector<mint7> a, b;
+    for (size_t i = 0; i < n + t * 17; i++) {
+      a.emplace_back(int(i * 5 + t));
+      b.emplace_back(int(i ^ 777));
+    }
+    return pair(a, b);
+  };
+  vector<thread> workers;
+  for (int t = 0; t < num_workers; t++) {
+    workers.emplace_back([&, t] {
+      // Different threads request different lengths first.
+      for (size_t k = 0; k < sizes.size(); k++) {
+        auto [a, b] = make_inputs(t, sizes[(k + t) % sizes.size()]);
+        results[t].push_back(convolve(a, b));
+      }
+    });
+  }
+  for (thread& w : workers) {
+    w.join();
+  }
+  for (int t = 0; t < num_workers; t++) {
+    for (size_t k = 0; k < sizes.size(); k++) {
+      auto [a, b] = make_inputs(t, sizes[(k + t) % sizes.size()]);
+      CHECK(results[t][k] == convolve(a, b));
+    }
+  }
+}
+
+TEST_CASE("Batched convolution", "[conv]") {
+  // Mixes empty, naive, Karatsuba and FFT sizes, in both orders of lengths.
+  vector<vector<mint>> a, b;
+  for (int n : {0, 3, 1, 40, 300, 1000, 70, 5, 700}) {
+    for (int m : {0, 1, 30, 300, 900}) {
+      a.emplace_back();
+      b.emplace_back();
+      for (int i = 0; i < n; i++) {
+        a.back().emplace_back(i * 7 + n);
+      }
+      for (int i = 0; i < m; i++) {
+        b.back().emplace_back(i * i + m);
+      }
+    }
+  }
+  vector<vector<mint>> expected;
+  for (size_t i = 0; i < a.size(); i++) {
+    expected.push_back(convolve(a[i], b[i]));
+  }
+  for (unsigned num_threads : {1, 2, 3, 100}) {
+    CHECK(convolve_batch(a, b, num_threads) == expected);
+  }
+  CHECK(convolve_batch(vector<vector<mint>>(), vector<vector<mint>>()).empty());
+}
+
+TEST_CASE("Truncated convolution", "[conv]") {
+  // Covers naive, half-length cyclic with wraparound correction, blocked and full-length transforms.
+  for (auto [n, m] :
+       vector<pair<int, int>>{{0, 5}, {5, 3}, {40, 50}, {300, 230}, {600, 500}, {1000, 1000}, {5000, 100}}) {
+    vector<mint> a = make_sequence<mint>(n, 3), b = make_sequence<mint>(m, 1);
+    vector<mint> full = n == 0 ? vector<mint>() : convolve(a, b);
+    for (size_t k : {size_t(0), size_t(1), size_t(17), size_t(256), size_t(300), size_t(520), full.size() + 5}) {
+      vector<mint> expected(k, mint(0));
+      copy(full.begin(), full.begin() + min(k, full.size()), expected.begin());
+      CHECK(convolve_truncated(a, b, k) == expected);
+    }
+  }
+}
+
+TEST_CASE("Middle product", "[conv]") {
+  for (auto [n, m] : vector<pair<int, int>>{{1, 1}, {10, 3}, {100, 100}, {1000, 1}, {1000, 400}, {1025, 1000}}) {
+    vector<mint> a = make_sequence<mint>(n, 3), b = make_sequence<mint>(m, 1);
+    vector<mint> full = convolve(a, b);
+    vector<mint> expected(full.begin() + (m - 1), full.begin() + n);
+    CHECK(middle_product(a, b) == expected);
+  }
+}
+
+TEMPLATE_TEST_CASE("Cyclic and negacyclic convolution", "[conv]", mint, MMInt<754974721>, cdouble) {
+  for (auto [n, m, k] : vector<tuple<int, int, size_t>>{
+           {1, 1, 1}, {10, 3, 4}, {100, 100, 100}, {64, 64, 64}, {1000, 700, 1024}, {3000, 1000, 1024}, {700, 800, 768},
+           {1500, 1200, 1280}, {0, 5, 8}}) {
+    vector<TestType> a = make_sequence<TestType>(n, 3), b = make_sequence<TestType>(m, 1);
+    vector<TestType> full = a;
+    impl::conv_naive_inplace(full, b);
+    vector<TestType> cyclic(k, TestType(0)), negacyclic(k, TestType(0));
+    for (size_t i = 0; i < full.size(); i++) {
+      cyclic[i % k] += full[i];
+      negacyclic[i % k] += i / k % 2 == 0 ? full[i] : -full[i];
+    }
+    vector<TestType> c = convolve_cyclic(a, b, k), d = convolve_negacyclic(a, b, k, 2);
+    REQUIRE(c.size() == k);
+    REQUIRE(d.size() == k);
+    for (size_t i = 0; i < k; i++) {
+      if constexpr (impl::is_complex_v<TestType>) {
+        CHECK(abs(c[i] - cyclic[i]) < 1e-6 * (1 + abs(cyclic[i])));
+        CHECK(abs(d[i] - negacyclic[i]) < 1e-6 * (1 + abs(negacyclic[i])));
+      } else {
+        CHECK(c[i] == cyclic[i]);
+        CHECK(d[i] == negacyclic[i]);
+      }
+    }
+  }
+}
+
+TEST_CASE("Negacyclic convolution without 2n-th root of unity", "[conv]") {
+  // 7681=15*2^9+1 has 2^9-th but not 2^10-th root of unity, so n=512 is the largest n, which takes linear convolution.
+  using mint_small = MMInt<7681>;
+  static_assert(radix2_fft_root<mint_small>::max_log == 9);
+  for (size_t n : {256, 512}) {
+    vector<mint_small> a = make_sequence<mint_small>(n, 3), b = make_sequence<mint_small>(n, 1), full = a;
+    impl::conv_naive_inplace(full, b);
+    vector<mint_small> expected(n, mint_small(0));
+    for (size_t i = 0; i < full.size(); i++) {
+      expected[i % n] += i / n % 2 == 0 ? full[i] : -full[i];
+    }
+    CHECK(convolve_negacyclic(a, b, n) == expected);
+  }
+}
+
+TEST_CASE("Squaring", "[conv]") {
+  for (int n : {0, 1, 5, 32, 33, 1000}) {
+    vector<mint> a = make_sequence<mint>(n, 7), b = a;
+    vector<mint> expected = n == 0 ? vector<mint>() : convolve(a, b);
+    CHECK(square(a) == expected);
+    CHECK(convolve(a, a) == expected);
+    vector<mint> c = a;
+    convolve_inplace(c, c);
+    CHECK(c == expected);
+  }
+}
+
+TEMPLATE_TEST_CASE("Karatsuba and blocked convolution", "[conv]", mint, mint64) {
+  vector<pair<int, int>> sizes{{1, 1}, {33, 33}, {40, 37}, {47, 300}, {100, 1000}, {30, 5000}, {300, 257}, {600, 2000}};
+  for (auto [n, m] : sizes) {
+    vector<TestType> a = make_sequence<TestType>(n, 3), b = make_sequence<TestType>(m, 1);
+    vector<TestType> expected = a, b_copy = b;
+    impl::conv_fft_inplace2(expected, b_copy, 1);
+    vector<TestType> c = a;
+    impl::conv_karatsuba_inplace(c, b);
+    CHECK(c == expected);
+    c = b;
+    impl::conv_karatsuba_inplace(c, a);
+    CHECK(c == expected);
+    c = a;
+    impl::conv_fft_blocked_inplace(c, b, 2);
+    CHECK(c == expected);
+    CHECK(convolve(a, b) == expected);
+  }
+}
@@ -0,0 +1,84 @@
+#include "cplib/conv/czt.hpp"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "cplib/num/mmint.hpp"
+#include "cplib/num/pow.hpp"
+#include "utils.hpp"
+using namespace std;
+using namespace cplib;
+using mint = MMInt<998244353>;
+using cdouble = complex<double>;
+
+namespace {
+
+mint evaluate(const vector<mint>& f, mint x) {
+  mint y(0);
+  for (size_t j = f.size(); j-- > 0;) {
+    y = y * x + f[j];
+  }
+  return y;
+}
+
+vector<cdouble> naive_dft(const vector<cdouble>& x, int sign) {
+  const size_t n = x.size();
+  vector<cdouble> ret(n);
+  for (size_t k = 0; k < n; k++) {
+    for (size_t j = 0; j < n; j++) {
+      ret[k] += x[j] * polar(1.0, sign * 2 * M_PI * double(j * k % n) / double(n));
+    }
+  }
+  return ret;
+}
+
+}  // namespace
+
+TEST_CASE("Chirp z-transform", "[czt]") {
+  const mint w(3), a(5);
+  for (size_t n : {0, 1, 7, 100, 1000}) {
+    for (size_t m : {0, 1, 10, 257, 1500}) {
+      vector<mint> f = make_sequence<mint>(n, int(m)), expected;
+      mint x = a;
+      for (size_t k = 0; k < m; k++) {
+        expected.push_back(evaluate(f, x));
+        x *= w;
+      }
+      CHECK(czt(f, w, m, a) == expected);
+    }
+  }
+}
+
+TEST_CASE("DFT of arbitrary length", "[czt]") {
+  CHECK(dft(vector<cdouble>()).empty());
+  for (size_t n : {1, 2, 3, 5, 12, 64, 100, 997, 1000}) {
+    vector<cdouble> x;
+    for (size_t i = 0; i < n; i++) {
+      x.emplace_back(sin(i * 0.7), cos(i * 1.3));
+    }
+    vector<cdouble> y = dft(x), expected = naive_dft(x, 1);
+    vector<cdouble> z = idft(y);
+    REQUIRE(y.size() == n);
+    REQUIRE(z.size() == n);
+    for (size_t i = 0; i < n; i++) {
+      CHECK(abs(y[i] - expected[i]) < 1e-9);
+      CHECK(abs(z[i] - x[i]) < 1e-12);
+    }
+  }
+}
+
+TEST_CASE("DFT with a root of unity modulo prime", "[czt]") {
+  // 998244352 = 2^23 * 7 * 17, so a 7*17-th root of unity exists.
+  const size_t n = 7 * 17;
+  const mint root = pow(mint(3), (mint::mod() - 1) / n);
+  vector<mint> x = make_sequence<mint>(n, 1), y = czt(x, root, n);
+  for (size_t k = 0; k < n; k++) {
+    CHECK(y[k] == evaluate(x, pow(root, k)));
+  }
+  vector<mint> z = czt(y, root.inv(), n);
+  for (size_t i = 0; i < n; i++) {
+    CHECK(z[i] == x[i] * mint(n));
+  }
+}
@@ -0,0 +1,124 @@
+#include "cplib/conv/fps.hpp"
+
+#include <optional>
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "cplib/num/mmint.hpp"
+#include "utils.hpp"
+using namespace std;
+using namespace cplib;
+using mint = MMInt<998244353>;
+using mint64 = MMInt64<4512606826625236993>;
+
+TEMPLATE_TEST_CASE("Power series inverse", "[fps]", mint, mint64) {
+  // Covers naive, exact powers of two and lengths just above them, with a longer and a shorter input.
+  for (size_t n : {1, 2, 30, 57, 64, 100, 1024, 1025, 3000}) {
+    for (size_t a_size : {n * 2, size_t(3)}) {
+      vector<TestType> a = make_sequence<TestType>(a_size, int(n));
+      vector<TestType> g = fps_inv(a, n);
+      REQUIRE(g.size() == n);
+      vector<TestType> expected(n, TestType(0));
+      expected[0] = TestType(1);
+      CHECK(convolve_truncated(a, g, n) == expected);
+    }
+  }
+  CHECK(fps_inv(vector<TestType>{TestType(5)}, 0).empty());
+}
+
+TEST_CASE("Multithreaded power series inverse", "[fps]") {
+  vector<mint> a = make_sequence<mint>(100000, 3);
+  vector<mint> expected = fps_inv(a, 100000);
+  for (unsigned num_threads : {2, 3, 8}) {
+    CHECK(fps_inv(a, 100000, num_threads) == expected);
+  }
+}
+
+TEST_CASE("Power series division", "[fps]") {
+  for (size_t n : {1, 20, 500, 2000}) {
+    vector<mint> a = make_sequence<mint>(n + 7, 2), b = make_sequence<mint>(n / 2 + 1, 5);
+    vector<mint> q = fps_div(a, b, n);
+    REQUIRE(q.size() == n);
+    vector<mint> expected(a.begin(), a.begin() + n);
+    CHECK(convolve_truncated(b, q, n) == expected);
+  }
+}
+
+TEMPLATE_TEST_CASE("Polynomial division", "[fps]", mint, mint64) {
+  for (auto [n, m] : vector<pair<size_t, size_t>>{{1, 1}, {3, 5}, {10, 1}, {100, 40}, {3000, 1000}, {3000, 2990},
+                                                  {5000, 3}, {4096, 2049}}) {
+    vector<TestType> a = make_sequence<TestType>(n, 1), b = make_sequence<TestType>(m, 4);
+    auto [q, r] = poly_divmod(a, b);
+    CHECK(q == poly_div(a, b));
+    CHECK(r == poly_mod(a, b));
+    REQUIRE(q.size() == (n >= m ? n - m + 1 : 0));
+    REQUIRE(r.size() == m - 1);
+    vector<TestType> bq = q.empty() ? vector<TestType>() : convolve(b, q);
+    bq.resize(n, TestType(0));
+    for (size_t i = 0; i < r.size(); i++) {
+      bq[i] += r[i];
+    }
+    CHECK(bq == a);
+  }
+}
+
+TEMPLATE_TEST_CASE("Power series logarithm and exponential", "[fps]", mint, mint64) {
+  // Covers naive, exact powers of two and lengths just above them.
+  for (size_t n : {1, 2, 20, 32, 33, 64, 100, 1024, 1025, 3000}) {
+    vector<TestType> a = make_sequence<TestType>(n + 3, int(n));
+    a[0] = TestType(0);
+    vector<TestType> f = fps_exp(a, n);
+    REQUIRE(f.size() == n);
+    // f'=a'f, i.e. (i+1)f_{i+1}=\sum_j (j+1)a_{j+1}f_{i-j}.
+    vector<TestType> da, df;
+    for (size_t i = 1; i < n; i++) {
+      da.push_back(a[i] * TestType(i));
+      df.push_back(f[i] * TestType(i));
+    }
+    CHECK(convolve_truncated(da, f, n - 1) == df);
+    vector<TestType> log_f = fps_log(f, n);
+    CHECK(log_f == vector<TestType>(a.begin(), a.begin() + n));
+  }
+  CHECK(fps_exp(vector<TestType>(), 3) == vector<TestType>{TestType(1), TestType(0), TestType(0)});
+  CHECK(fps_log(vector<TestType>{TestType(1)}, 0).empty());
+}
+
+TEST_CASE("Power series power", "[fps]") {
+  for (auto [n, d] : vector<pair<size_t, size_t>>{{1, 0}, {10, 0}, {10, 2}, {200, 0}, {200, 3}, {1500, 1}}) {
+    vector<mint> a = make_sequence<mint>(n, 7);
+    fill(a.begin(), a.begin() + min(d, n), mint(0));
+    for (uint64_t k : {0, 1, 2, 5, 70}) {
+      vector<mint> expected(n, mint(0));
+      expected[0] = mint(1);
+      for (uint64_t i = 0; i < k; i++) {
+        expected = convolve_truncated(expected, a, n);
+      }
+      CHECK(fps_pow(a, k, n) == expected);
+    }
+  }
+  // a^k is a^{k mod p} for lengths below p, since a^p=a_0^p+O(x^p).
+  vector<mint> a = make_sequence<mint>(100, 1);
+  CHECK(fps_pow(a, mint::mod() + 3, 100) == fps_pow(a, 3, 100));
+  CHECK(fps_pow(vector<mint>(5, mint(0)), 3, 4) == vector<mint>(4, mint(0)));
+  CHECK(fps_pow(vector<mint>{mint(0), mint(2)}, uint64_t(1) << 62, 4) == vector<mint>(4, mint(0)));
+}
+
+TEMPLATE_TEST_CASE("Power series square root", "[fps]", mint, mint64) {
+  for (size_t n : {1, 5, 31, 32, 33, 100, 1024, 1025, 3000}) {
+    for (size_t d : {0, 4}) {
+      vector<TestType> s = make_sequence<TestType>(n, int(n));
+      s[0] = TestType(3);
+      vector<TestType> a = convolve_truncated(s, s, n);
+      a.insert(a.begin(), d, TestType(0));
+      optional<vector<TestType>> r = fps_sqrt(a, n);
+      REQUIRE(r);
+      REQUIRE(r->size() == n);
+      CHECK(convolve_truncated(*r, *r, n) == vector<TestType>(a.begin(), a.begin() + n));
+    }
+  }
+  // 5 is not a quadratic residue modulo either prime.
+  CHECK(!fps_sqrt(vector<TestType>{TestType(5), TestType(1)}, 5));
+  CHECK(!fps_sqrt(vector<TestType>{TestType(0), TestType(1)}, 5));
+  CHECK(fps_sqrt(vector<TestType>{TestType(0), TestType(1)}, 1) == vector<TestType>{TestType(0)});
+  CHECK(fps_sqrt(vector<TestType>(), 2) == vector<TestType>(2, TestType(0)));
+}
@@ -0,0 +1,113 @@
+#include "cplib/conv/linear_recurrence.hpp"
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "cplib/num/mmint.hpp"
+using namespace std;
+using namespace cplib;
+using mint = MMInt<998244353>;
+using mint64 = MMInt64<4512606826625236993>;
+
+namespace {
+
+// First n terms of the sequence with initial terms a and recurrence q, where q[0]=1.
+template <typename T>
+vector<T> extend_sequence(vector<T> a, const vector<T>& q, size_t n) {
+  while (a.size() < n) {
+    T next(0);
+    for (size_t j = 1; j < q.size(); j++) {
+      next -= q[j] * a[a.size() - j];
+    }
+    a.push_back(next);
+  }
+  return a;
+}
+
+}  // namespace
+
+TEST_CASE("Berlekamp-Massey on small sequences", "[linear_recurrence]") {
+  using v = vector<mint>;
+  CHECK(berlekamp_massey(v{}) == v{mint(1)});
+  CHECK(berlekamp_massey(v{mint(0), mint(0), mint(0)}) == v{mint(1)});
+  // Any recurrence of order 3 fits, as there is no term to check it against.
+  CHECK(berlekamp_massey(v{mint(0), mint(0), mint(5)}).size() == 4);
+  CHECK(berlekamp_massey(v{mint(2), mint(6), mint(18), mint(54)}) == v{mint(1), -mint(3)});
+  // Fibonacci numbers.
+  CHECK(berlekamp_massey(v{mint(0), mint(1), mint(1), mint(2), mint(3), mint(5)}) == v{mint(1), -mint(1), -mint(1)});
+}
+
+TEMPLATE_TEST_CASE("Berlekamp-Massey recovers recurrences", "[linear_recurrence]", mint, mint64) {
+  for (size_t d : {1, 5, 40, 200}) {
+    vector<TestType> q{TestType(1)}, a;
+    for (size_t j = 1; j <= d; j++) {
+      q.emplace_back(int(j * j * 3 + 7));
+      a.emplace_back(int(j * 11 + 2));
+    }
+    vector<TestType> s = extend_sequence(a, q, d * 2 + 10);
+    CHECK(berlekamp_massey(s) == q);
+  }
+}
+
+TEMPLATE_TEST_CASE("Coefficient of rational series", "[linear_recurrence]", mint, mint64) {
+  // Covers short inputs done on coefficients and long ones done on transforms, with numerators longer and shorter.
+  for (size_t d : {1, 3, 30, 100, 700}) {
+    for (size_t p_size : {d / 2 + 1, d * 2}) {
+      vector<TestType> p, q{TestType(3)};
+      for (size_t i = 0; i < p_size; i++) {
+        p.emplace_back(int(i * 5 + 1));
+      }
+      for (size_t j = 1; j <= d; j++) {
+        q.emplace_back(int(j * j + 2));
+      }
+      // p/q by long division.
+      const size_t n = d * 3 + 100;
+      vector<TestType> series;
+      const TestType q0_inv = TestType(1) / q[0];
+      for (size_t i = 0; i < n; i++) {
+        TestType x = i < p.size() ? p[i] : TestType(0);
+        for (size_t j = 1; j < q.size() && j <= i; j++) {
+          x -= q[j] * series[i - j];
+        }
+        series.push_back(x * q0_inv);
+      }
+      for (uint64_t k : {uint64_t(0), uint64_t(1), uint64_t(d), uint64_t(n - 1)}) {
+        CHECK(kth_coefficient(p, q, k) == series[k]);
+      }
+      const uint64_t k = 1000000000000000000;
+      CHECK(kth_coefficient(p, q, k) == impl::kth_coefficient_naive(p, q, k));
+    }
+  }
+  CHECK(kth_coefficient(vector<TestType>(), vector<TestType>{TestType(1)}, 5) == TestType(0));
+  CHECK(kth_coefficient(vector<TestType>{TestType(1)}, vector<TestType>{TestType(1)}, 1) == TestType(0));
+}
+
+TEST_CASE("Multithreaded coefficient of rational series", "[linear_recurrence]") {
+  vector<mint> p, q{mint(1)};
+  for (int i = 0; i < 5000; i++) {
+    p.emplace_back(i + 1);
+    q.emplace_back(i * 7 + 3);
+  }
+  const mint expected = kth_coefficient(p, q, 123456789);
+  for (unsigned num_threads : {2, 3, 8}) {
+    CHECK(kth_coefficient(p, q, 123456789, num_threads) == expected);
+  }
+}
+
+TEST_CASE("K-th term of linear recurrence", "[linear_recurrence]") {
+  const vector<mint> fib{mint(0), mint(1)}, q{mint(1), -mint(1), -mint(1)};
+  CHECK(linear_recurrence_kth_term(fib, q, 0) == mint(0));
+  CHECK(linear_recurrence_kth_term(fib, q, 100) == mint(494958974));
+  CHECK(linear_recurrence_kth_term(fib, q, 1000000000000000000) == mint(23849548));
+  // A recurrence found by Berlekamp-Massey, long enough to be done on transforms.
+  vector<mint> a, r{mint(1)};
+  for (int j = 1; j <= 300; j++) {
+    r.emplace_back(j * 17 + 1);
+    a.emplace_back(j * j);
+  }
+  vector<mint> s = extend_sequence(a, r, 2000);
+  vector<mint> found = berlekamp_massey(vector<mint>(s.begin(), s.begin() + 600));
+  REQUIRE(found == r);
+  for (uint64_t k : {0, 299, 300, 1000, 1999}) {
+    CHECK(linear_recurrence_kth_term(a, found, k) == s[k]);
+  }
+}
@@ -0,0 +1,61 @@
+#include "cplib/conv/multipoint.hpp"
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "cplib/num/mmint.hpp"
+#include "utils.hpp"
+using namespace std;
+using namespace cplib;
+using mint = MMInt<998244353>;
+using mint64 = MMInt64<4512606826625236993>;
+
+namespace {
+
+template <typename T>
+vector<T> horner(const vector<T>& f, const vector<T>& xs) {
+  vector<T> ret;
+  for (const T& x : xs) {
+    T y(0);
+    for (size_t j = f.size(); j-- > 0;) {
+      y = y * x + f[j];
+    }
+    ret.push_back(y);
+  }
+  return ret;
+}
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("Multipoint evaluation", "[multipoint]", mint, mint64) {
+  // Covers Horner's method, fewer points than coefficients and the other way around, and repeated points.
+  for (auto [n, m] : vector<pair<size_t, size_t>>{
+           {0, 3}, {5, 0}, {1, 100}, {10, 10}, {100, 100}, {300, 1000}, {1000, 300}, {1024, 1024}, {1025, 1025}}) {
+    vector<TestType> f = make_sequence<TestType>(n, 3), xs = make_sequence<TestType>(m, 11);
+    for (size_t i = 0; i < m; i += 7) {
+      xs[i] = xs[i / 2];
+    }
+    CHECK(multipoint_evaluate(f, xs) == horner(f, xs));
+  }
+}
+
+TEST_CASE("Multithreaded multipoint evaluation", "[multipoint]") {
+  vector<mint> f = make_sequence<mint>(5000, 1), xs = make_sequence<mint>(6000, 2);
+  vector<mint> expected = multipoint_evaluate(f, xs);
+  for (unsigned num_threads : {2, 3, 8}) {
+    CHECK(multipoint_evaluate(f, xs, num_threads) == expected);
+  }
+}
+
+TEMPLATE_TEST_CASE("Polynomial interpolation", "[multipoint]", mint, mint64) {
+  for (size_t n : {0, 1, 2, 57, 100, 1024, 1500}) {
+    vector<TestType> f = make_sequence<TestType>(n, 5), xs;
+    for (size_t i = 0; i < n; i++) {
+      xs.emplace_back(int(i * 3 + 1));
+    }
+    vector<TestType> ys = horner(f, xs);
+    CHECK(interpolate(xs, ys) == f);
+    if (n > 1) {
+      CHECK(interpolate(xs, ys, 4) == f);
+    }
+  }
+}
@@ -0,0 +1,56 @@
+#include "cplib/conv/online.hpp"
+
+#include <complex>
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "cplib/num/mmint.hpp"
+using namespace std;
+using namespace cplib;
+using mint = MMInt<998244353>;
+using mint64 = MMInt64<4512606826625236993>;
+
+TEMPLATE_TEST_CASE("Online convolution", "[online]", mint, mint64) {
+  // Long enough for naive and FFT blocks, and not a power of two.
+  const size_t n = 3000;
+  vector<TestType> a, b;
+  for (size_t i = 0; i < n; i++) {
+    a.emplace_back(int(i * i * 7 + 3));
+    b.emplace_back(int(i * 13 + 5));
+  }
+  vector<TestType> expected = convolve(a, b);
+  OnlineConvolution<TestType> conv;
+  for (size_t i = 0; i < n; i++) {
+    CHECK(conv.push(a[i], b[i]) == expected[i]);
+  }
+  CHECK(conv.size() == n);
+}
+
+TEST_CASE("Online convolution of complex numbers", "[online]") {
+  const size_t n = 500;
+  vector<complex<double>> a, b;
+  for (size_t i = 0; i < n; i++) {
+    a.emplace_back(double(i % 7), double(i % 3));
+    b.emplace_back(double(i % 5), -double(i % 11));
+  }
+  vector<complex<double>> expected = convolve(a, b);
+  OnlineConvolution<complex<double>> conv;
+  for (size_t i = 0; i < n; i++) {
+    CHECK(abs(conv.push(a[i], b[i]) - expected[i]) < 1e-6);
+  }
+}
+
+TEST_CASE("Online convolution with inputs depending on outputs", "[online]") {
+  // Catalan numbers C_{i+1}=\sum_j C_jC_{i-j}.
+  const size_t n = 1000;
+  vector<mint> catalan{mint(1)};
+  for (size_t i = 0; i < n; i++) {
+    catalan.push_back(catalan[i] * mint(int(i * 4 + 2)) / mint(int(i + 2)));
+  }
+  OnlineConvolution<mint> conv;
+  mint c(1);
+  for (size_t i = 0; i < n; i++) {
+    c = conv.push(c, c);
+    CHECK(c == catalan[i + 1]);
+  }
+}
@@ -0,0 +1,40 @@
+#include "cplib/conv/prepared.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+#include "cplib/num/mmint.hpp"
+#include "utils.hpp"
+using namespace std;
+using namespace cplib;
+using mint = MMInt<998244353>;
+
+TEST_CASE("Prepared convolution against fixed kernel", "[prepared]") {
+  vector<mint> b = make_sequence<mint>(100, 3);
+  PreparedConvolution<mint> conv(b, 200);
+  CHECK(conv.kernel_size() == 100);
+  CHECK(conv.fft_size() == 512);
+  CHECK(conv.max_input_size() == 413);
+  for (size_t n : {0, 1, 10, 33, 200, 413, 414, 1000, 5000}) {
+    vector<mint> a = make_sequence<mint>(n, int(n));
+    vector<mint> expected = n == 0 ? vector<mint>() : convolve(a, b);
+    CHECK(conv.apply(a) == expected);
+  }
+}
+
+TEST_CASE("Streaming convolution", "[prepared]") {
+  vector<mint> b = make_sequence<mint>(50, 5);
+  PreparedConvolution<mint> conv(b, 64);
+  ConvolutionStream<mint> stream(conv);
+  for (size_t piece : {1, 7, 100, 1000}) {
+    vector<mint> a = make_sequence<mint>(3000, int(piece)), out;
+    for (size_t start = 0; start < a.size(); start += piece) {
+      vector<mint> input(a.begin() + start, a.begin() + min(a.size(), start + piece));
+      vector<mint> part = stream.push(input);
+      CHECK(out.size() + part.size() <= start + input.size());
+      out.insert(out.end(), part.begin(), part.end());
+    }
+    vector<mint> rest = stream.finish();
+    out.insert(out.end(), rest.begin(), rest.end());
+    CHECK(out == convolve(a, b));
+  }
+  CHECK(stream.finish().empty());
+}
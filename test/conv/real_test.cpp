@@ -0,0 +1,72 @@
+#include "cplib/conv/real.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "utils.hpp"
+using namespace std;
+using namespace cplib;
+
+namespace {
+
+// make_sequence() reduced to [-10000,10000], small enough for exact results in double.
+vector<int64_t> make_small_sequence(size_t n, int seed) {
+  vector<int64_t> a = make_sequence<int64_t>(n, seed);
+  for (int64_t& x : a) {
+    x = x % 20001 - 10000;
+  }
+  return a;
+}
+
+}  // namespace
+
+TEST_CASE("Small real convolution", "[real]") {
+  vector<int> a{1, 2, 3, 4}, b{5, 6, 7, 8, 9};
+  CHECK(convolve_real(a, b) == vector<int>{5, 16, 34, 60, 70, 70, 59, 36});
+  CHECK(convolve_real(a, vector<int>()).empty());
+  vector<double> c{0.5, -1.5}, d{2, 4};
+  CHECK(convolve_real(c, d) == vector<double>{1, -1, -6});
+}
+
+TEST_CASE("Real convolution of integers", "[real]") {
+  for (size_t n : {49, 100, 1000, 4097}) {
+    for (size_t m : {49, 64, 999}) {
+      vector<int64_t> a = make_small_sequence(n, int(m)), b = make_small_sequence(m, int(n));
+      vector<int64_t> expected = a;
+      impl::conv_naive_inplace(expected, b);
+      CHECK(convolve_real(a, b) == expected);
+      CHECK(convolve_real(a, b, 4) == expected);
+    }
+  }
+}
+
+TEST_CASE("Real convolution of doubles", "[real]") {
+  vector<double> a, b;
+  for (int i = 0; i < 3000; i++) {
+    a.push_back(std::sin(i) * 1e-3);
+  }
+  for (int i = 0; i < 500; i++) {
+    b.push_back(std::cos(i * 0.3) * 1e6);
+  }
+  vector<double> expected = a;
+  impl::conv_naive_inplace(expected, b);
+  vector<double> c = convolve_real(a, b);
+  REQUIRE(c.size() == expected.size());
+  for (size_t i = 0; i < c.size(); i++) {
+    CHECK(std::abs(c[i] - expected[i]) < 1e-7);
+  }
+}
+
+TEST_CASE("Real convolution at the error bound", "[real]") {
+  // max|a|max|b|min(N1,N2)=10^13, with magnitudes far apart.
+  const size_t n = 1 << 16;
+  const int64_t x = 1 << 22, y = int64_t(1e13) / n / x;
+  vector<int64_t> a(n, x), b(n, y);
+  vector<int64_t> expected;
+  for (size_t i = 0; i < n * 2 - 1; i++) {
+    expected.push_back(x * y * int64_t(min(i + 1, n * 2 - 1 - i)));
+  }
+  CHECK(convolve_real(a, b) == expected);
+}
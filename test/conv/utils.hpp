@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <vector>
 
 template <typename ModInt>
@@ -16,4 +17,24 @@ inline std::vector<int> to_int_vec(const std::vector<ModInt>& a) {
     res.push_back(x.val());
   }
   return res;
-}
\ No newline at end of file
+}
+
+// Deterministic test sequence a_i=7i^2+seed*i+seed, constructed from int.
+template <typename T>
+inline std::vector<T> make_sequence(std::size_t n, int seed) {
+  std::vector<T> res;
+  for (std::size_t i = 0; i < n; i++) {
+    res.emplace_back(int(i * i * 7 + i * seed + seed));
+  }
+  return res;
+}
+
+// Deterministic test sequence a_i=-1-i*step, which is close to the modulus for small i.
+template <typename ModInt>
+inline std::vector<ModInt> make_sequence_near_modulus(std::size_t n, unsigned step) {
+  std::vector<ModInt> res;
+  for (std::size_t i = 0; i < n; i++) {
+    res.push_back(-ModInt(i * step + 1));
+  }
+  return res;
+}
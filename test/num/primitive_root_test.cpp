@@ -52,4 +52,14 @@ TEST_CASE("No primitive root", "[primitive_root]") {
   CHECK_FALSE(primitive_root(3u * 1000000007u));
   CHECK_FALSE(primitive_root(4u * 1000000007u));
   CHECK_FALSE(primitive_root(65519u * 65521u));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Primitive root at compile time", "[primitive_root]") {
+  static_assert(primitive_root_prime_constexpr(2u) == 1u);
+  static_assert(primitive_root_prime_constexpr(998244353u) == 3u);
+  static_assert(primitive_root_prime_constexpr(754974721u) == 11u);
+  static_assert(primitive_root_prime_constexpr(4512606826625236993ull) == 7u);
+  for (uint32_t p : {3u, 5u, 7u, 167772161u, 469762049u, 1000000007u, 4294967291u}) {
+    CHECK(primitive_root_prime_constexpr(p) == primitive_root_prime(p));
+  }
+}